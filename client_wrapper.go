@@ -57,6 +57,7 @@ func (qc *QuicClient) StartConnect() {
 		quicClientSession_c: C.create_go_quic_client_session_and_initialize(
 			C.GoPtr(clientWriterPtr.Set(qc.conn.Writer())),
 			C.GoPtr(taskRunnerPtr.Set(qc.taskRunner)),
+			qc.taskRunner.timerWheel,
 			C.GoPtr(proofVerifierPtr.Set(qc.proofVerifier)),
 			(*C.uint8_t)(unsafe.Pointer(&addr.packed[0])),
 			C.size_t(len(addr.packed)),
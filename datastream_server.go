@@ -1,9 +1,9 @@
 package goquic
 
 import (
-	"bufio"
 	"bytes"
 	"fmt"
+	"io"
 	"io/ioutil"
 	"net/http"
 	"net/url"
@@ -31,18 +31,47 @@ func (s *SpdyServerSession) CreateIncomingDynamicStream(quicServerStream *QuicSe
 type SimpleServerStream struct {
 	closed           bool
 	streamId         uint32 // Just for logging purpose
-	header           http.Header
+	pseudo           RequestPseudoHeaders
+	header           http.Header // Canonical names, no pseudo-headers
 	peerAddress      string
 	buffer           *bytes.Buffer
 	server           *QuicSpdyServer
 	quicServerStream *QuicServerStream
 	sessionFnChan    chan func()
 	closeNotifyChan  chan bool
+	body             *requestBody // Only set when streaming the request body
 }
 
 func (stream *SimpleServerStream) OnInitialHeadersComplete(header http.Header, peerAddress string) {
+	pseudo := RequestPseudoHeaders{
+		Method:    header.Get(":method"),
+		Path:      header.Get(":path"),
+		Authority: header.Get(":authority"),
+		Scheme:    header.Get(":scheme"),
+		Version:   header.Get(":version"),
+	}
+	canonical := make(http.Header, len(header))
+	for k, v := range header {
+		// Remove SPDY headers
+		if len(k) > 0 && k[0] == ':' {
+			continue
+		}
+		canonical[canonicalHeaderName(k)] = v
+	}
+	stream.OnRequestHeadersComplete(pseudo, canonical, peerAddress)
+}
+
+func (stream *SimpleServerStream) OnRequestHeadersComplete(pseudo RequestPseudoHeaders, header http.Header, peerAddress string) {
+	stream.pseudo = pseudo
 	stream.header = header
 	stream.peerAddress = peerAddress
+
+	// A request the stream already answered must not reach a handler.
+	if stream.server.StreamRequestBody && !stream.quicServerStream.WriteSideClosed() {
+		stream.quicServerStream.EnableBodyStreaming()
+		stream.body = newRequestBody(stream)
+		stream.ProcessRequest()
+	}
 }
 
 func (stream *SimpleServerStream) OnTrailingHeadersComplete(header http.Header) {
@@ -50,6 +79,14 @@ func (stream *SimpleServerStream) OnTrailingHeadersComplete(header http.Header)
 }
 
 func (stream *SimpleServerStream) OnDataAvailable(data []byte, isClosed bool) {
+	if stream.body != nil {
+		stream.body.write(data)
+		if isClosed {
+			stream.body.finish(io.EOF)
+		}
+		return
+	}
+
 	stream.buffer.Write(data)
 	if isClosed {
 		stream.ProcessRequest()
@@ -61,39 +98,60 @@ func (stream *SimpleServerStream) OnClose() {
 		stream.closeNotifyChan <- true
 	}
 	stream.closed = true
+	if stream.body != nil {
+		stream.body.finish(io.ErrUnexpectedEOF)
+	}
 }
 
-func (stream *SimpleServerStream) ProcessRequest() {
-	header := stream.header
-	req := new(http.Request)
-	req.Method = header.Get(":method")
-	req.RequestURI = header.Get(":path")
-	req.Proto = header.Get(":version")
-	req.Header = make(map[string][]string, len(header))
-	for k, v := range header {
-		// Remove SPDY headers
-		if len(k) > 0 && k[0] == ':' {
-			continue
+// markBodyConsumed and stopReadingBody are called from the handler goroutine.
+func (stream *SimpleServerStream) markBodyConsumed(n int) {
+	stream.sessionFnChan <- func() {
+		if stream.closed {
+			return
 		}
-		req.Header[http.CanonicalHeaderKey(k)] = v
+		stream.quicServerStream.MarkBodyConsumed(n)
 	}
-	req.Host = header.Get(":authority")
+}
+
+func (stream *SimpleServerStream) stopReadingBody() {
+	stream.sessionFnChan <- func() {
+		if stream.closed {
+			return
+		}
+		stream.quicServerStream.StopReadingBody()
+	}
+}
+
+func (stream *SimpleServerStream) ProcessRequest() {
+	pseudo := &stream.pseudo
+	req := new(http.Request)
+	req.Method = pseudo.Method
+	req.RequestURI = pseudo.Path
+	req.Proto = pseudo.Version
+	req.Header = stream.header
+	req.Host = pseudo.Authority
 	req.RemoteAddr = stream.peerAddress
-	rawPath := header.Get(":path")
 
-	url, err := url.ParseRequestURI(rawPath)
+	url, err := parseRequestPath(pseudo.Path)
 	if err != nil {
 		fmt.Println(" Error! ", err)
 		return
 		// TODO(serialx): Send error message
 	}
 
-	url.Scheme = header.Get(":scheme")
-	url.Host = header.Get(":authority")
+	url.Scheme = pseudo.Scheme
+	url.Host = pseudo.Authority
 	req.URL = url
-	// TODO(serialx): To buffered async read
-	req.Body = ioutil.NopCloser(stream.buffer)
-	req.ContentLength = int64(stream.buffer.Len())
+	if stream.body != nil {
+		req.Body = stream.body
+		req.ContentLength = -1
+		if cl, err := strconv.ParseInt(req.Header.Get("Content-Length"), 10, 64); err == nil && cl >= 0 {
+			req.ContentLength = cl
+		}
+	} else {
+		req.Body = ioutil.NopCloser(stream.buffer)
+		req.ContentLength = int64(stream.buffer.Len())
+	}
 
 	go func() {
 		w := &spdyResponseWriter{
@@ -101,17 +159,15 @@ func (stream *SimpleServerStream) ProcessRequest() {
 			spdyStream:   stream,
 			header:       make(http.Header),
 		}
-		sw := &spdyResponseBufferedWriter{
-			serverStream: stream.quicServerStream,
-			spdyStream:   stream,
-		}
-		w.w = bufio.NewWriter(sw)
+		w.w = &responseBodyWriter{stream: stream}
 
 		if stream.server.Handler != nil {
 			stream.server.Handler.ServeHTTP(w, req)
 		} else {
 			http.DefaultServeMux.ServeHTTP(w, req)
 		}
+		// Discards whatever part of a streamed body the handler did not read.
+		req.Body.Close()
 
 		err := w.w.Flush()
 		if err != nil {
@@ -140,6 +196,23 @@ func (stream *SimpleServerStream) ProcessRequest() {
 	}()
 }
 
+// parseRequestPath is url.ParseRequestURI with a fast path for the common
+// case of a path without escapes, optionally followed by a query.
+func parseRequestPath(rawPath string) (*url.URL, error) {
+	if len(rawPath) == 0 || rawPath[0] != '/' {
+		return url.ParseRequestURI(rawPath)
+	}
+	for i := 0; i < len(rawPath); i++ {
+		switch c := rawPath[i]; {
+		case c == '?':
+			return &url.URL{Path: rawPath[:i], RawQuery: rawPath[i+1:]}, nil
+		case c == '%' || c == '#' || c < 0x20 || c == 0x7f:
+			return url.ParseRequestURI(rawPath)
+		}
+	}
+	return &url.URL{Path: rawPath}, nil
+}
+
 func (stream *SimpleServerStream) closeNotify() <-chan bool {
 	if stream.closeNotifyChan == nil {
 		stream.closeNotifyChan = make(chan bool, 1)
@@ -153,7 +226,7 @@ type spdyResponseWriter struct {
 	header       http.Header
 	headerSent   http.Header
 	wroteHeader  bool
-	w            *bufio.Writer
+	w            *responseBodyWriter
 }
 
 func (w *spdyResponseWriter) Header() http.Header {
@@ -202,21 +275,3 @@ func (w *spdyResponseWriter) CloseNotify() <-chan bool {
 func (w *spdyResponseWriter) Flush() {
 	w.w.Flush()
 }
-
-type spdyResponseBufferedWriter struct {
-	serverStream *QuicServerStream
-	spdyStream   *SimpleServerStream
-}
-
-func (sw *spdyResponseBufferedWriter) Write(buffer []byte) (int, error) {
-	copiedBuf := make([]byte, len(buffer))
-	copy(copiedBuf, buffer)
-
-	sw.spdyStream.sessionFnChan <- func() {
-		if sw.spdyStream.closed {
-			return
-		}
-		sw.serverStream.WriteOrBufferData(copiedBuf, false)
-	}
-	return len(buffer), nil
-}
@@ -5,6 +5,7 @@ package goquic
 import "C"
 import (
 	"net"
+	"time"
 	"unsafe"
 )
 
@@ -13,6 +14,10 @@ type QuicDispatcher struct {
 	quicServerSessions      map[*QuicServerSession]bool
 	TaskRunner              *TaskRunner
 	createQuicServerSession func() IncomingDataStreamCreator
+
+	// Completions of proofs signed by the ProofSource workers. They must run
+	// on the dispatcher's loop.
+	proofDone chan func()
 }
 
 type QuicServerSession struct {
@@ -25,15 +30,72 @@ type QuicEncryptedPacket struct {
 	encryptedPacket unsafe.Pointer
 }
 
-func CreateQuicDispatcher(writer *ServerWriter, createQuicServerSession func() IncomingDataStreamCreator, taskRunner *TaskRunner, cryptoConfig *QuicCryptoServerConfig) *QuicDispatcher {
+// DispatcherConfig controls the connection IDs a dispatcher chooses for its
+// clients (see GoQuicConnectionIdGenerator).
+type DispatcherConfig struct {
+	ShardIndex int
+	NumShards  int
+
+	// If non-zero, stored in the top 16 bits of every connection ID chosen by
+	// the dispatcher so that an L4 load balancer can route without state.
+	ServerId uint16
+
+	// Maximum number of connection IDs kept in time-wait state. Zero uses
+	// the libquic default; negative means unlimited.
+	TimeWaitListMaxConnections int
+
+	// If set, the dispatcher creates sessions only within the budget given
+	// to ProcessBufferedChlos for each loop iteration, buffering further
+	// CHLOs. Call EnableBufferPacketsTillChlo first.
+	LimitNewSessionsPerLoop bool
+
+	// Admission control of new connections; zero disables each check. A
+	// CHLO turned away is answered with a CONNECTION_CLOSE from the
+	// time-wait list instead of creating a session.
+	MaxSessions        int           // Open sessions of the dispatcher
+	MaxLoopLag         time.Duration // Smoothed event loop lag
+	ChloRatePerPrefix  float64       // CHLOs per second per /24 or /48
+	ChloBurstPerPrefix float64       // Defaults to ChloRatePerPrefix
+
+	// Packets per second accepted from one IPv4 address or IPv6 /56 which
+	// do not belong to an open session, checked before they are parsed.
+	// Zero disables the limit.
+	UnknownPacketRatePerSource  float64
+	UnknownPacketBurstPerSource float64 // Defaults to the rate
+}
+
+func CreateQuicDispatcher(writer *ServerWriter, createQuicServerSession func() IncomingDataStreamCreator, taskRunner *TaskRunner, cryptoConfig *QuicCryptoServerConfig, config DispatcherConfig) *QuicDispatcher {
 	dispatcher := &QuicDispatcher{
 		quicServerSessions:      make(map[*QuicServerSession]bool),
 		TaskRunner:              taskRunner,
 		createQuicServerSession: createQuicServerSession,
+		proofDone:               make(chan func(), proofJobQueueSize),
+	}
+
+	config_c := C.struct_GoQuicDispatcherConfig{
+		Shard_index: C.uint32_t(config.ShardIndex),
+		Num_shards:  C.uint32_t(config.NumShards),
+		Server_id:   C.uint16_t(config.ServerId),
+
+		Time_wait_max_connections: C.int32_t(config.TimeWaitListMaxConnections),
+
+		Max_sessions:          C.uint32_t(config.MaxSessions),
+		Max_loop_lag_us:       C.int64_t(config.MaxLoopLag / time.Microsecond),
+		Chlo_rate_per_prefix:  C.double(config.ChloRatePerPrefix),
+		Chlo_burst_per_prefix: C.double(config.ChloBurstPerPrefix),
+
+		Unknown_packet_rate_per_source:  C.double(config.UnknownPacketRatePerSource),
+		Unknown_packet_burst_per_source: C.double(config.UnknownPacketBurstPerSource),
+	}
+	if config.ServerId != 0 {
+		config_c.Use_server_id = 1
+	}
+	if config.LimitNewSessionsPerLoop {
+		config_c.Limit_new_sessions_per_loop = 1
 	}
 
 	dispatcher.quicDispatcher = C.create_quic_dispatcher(
-		C.GoPtr(serverWriterPtr.Set(writer)), C.GoPtr(quicDispatcherPtr.Set(dispatcher)), C.GoPtr(taskRunnerPtr.Set(taskRunner)), cryptoConfig.cryptoServerConfig)
+		C.GoPtr(serverWriterPtr.Set(writer)), C.GoPtr(quicDispatcherPtr.Set(dispatcher)), C.GoPtr(taskRunnerPtr.Set(taskRunner)), taskRunner.timerWheel, cryptoConfig.cryptoServerConfig, &config_c)
 	return dispatcher
 }
 
@@ -52,11 +114,141 @@ func (d *QuicDispatcher) ProcessPacket(self_address *net.UDPAddr, peer_address *
 	)
 }
 
-func (d *QuicDispatcher) Statistics() DispatcherStatistics {
-	stat := DispatcherStatistics{make([]SessionStatistics, 0)}
+const (
+	maxPacketBatchSize    = 64
+	packetBatchBufferSize = maxPacketBatchSize * 1500 // 1500 = MTU (kMaxPacketSize)
+)
+
+// PacketBatch gathers received datagrams into one contiguous buffer so that
+// they can be handed to the dispatcher with a single cgo call.
+type PacketBatch struct {
+	buf   []byte
+	descs []C.struct_GoPacketDesc
+}
+
+func NewPacketBatch() *PacketBatch {
+	return &PacketBatch{
+		buf:   make([]byte, 0, packetBatchBufferSize),
+		descs: make([]C.struct_GoPacketDesc, 0, maxPacketBatchSize),
+	}
+}
+
+// Add copies the datagram into the batch. It returns false if the batch is
+// full; the caller should process the batch and retry.
+func (b *PacketBatch) Add(peer_address *net.UDPAddr, buffer []byte, timestamp int64) bool {
+	if len(b.descs) == cap(b.descs) || len(b.buf)+len(buffer) > cap(b.buf) {
+		return false
+	}
+
+	desc := C.struct_GoPacketDesc{
+		Peer_port: C.uint16_t(peer_address.Port),
+		Offset:    C.size_t(len(b.buf)),
+		Length:    C.size_t(len(buffer)),
+		Timestamp: C.int64_t(timestamp),
+	}
+	ip := peer_address.IP.To4()
+	if ip == nil {
+		ip = peer_address.IP
+	}
+	for i, v := range ip {
+		desc.Peer_ip[i] = C.uint8_t(v)
+	}
+	desc.Peer_ip_len = C.int(len(ip))
+
+	b.buf = append(b.buf, buffer...)
+	b.descs = append(b.descs, desc)
+	return true
+}
+
+func (b *PacketBatch) Len() int {
+	return len(b.descs)
+}
+
+func (b *PacketBatch) Reset() {
+	b.buf = b.buf[:0]
+	b.descs = b.descs[:0]
+}
+
+// ProcessPackets feeds every datagram in the batch to the dispatcher and
+// resets the batch.
+func (d *QuicDispatcher) ProcessPackets(self_address *net.UDPAddr, batch *PacketBatch) {
+	if batch.Len() == 0 {
+		return
+	}
+
+	self_address_p := CreateIPEndPoint(self_address)
+	C.quic_dispatcher_process_packets(
+		d.quicDispatcher,
+		(*C.uint8_t)(unsafe.Pointer(&self_address_p.packed[0])),
+		C.size_t(len(self_address_p.packed)),
+		C.uint16_t(self_address_p.port),
+		&batch.descs[0], C.size_t(len(batch.descs)),
+		(*C.char)(unsafe.Pointer(&batch.buf[0])),
+	)
+	batch.Reset()
+}
+
+// FlushWrites hands every packet queued by the C++ writer since the last
+// flush to the writer goroutine.
+func (d *QuicDispatcher) FlushWrites() {
+	C.quic_dispatcher_flush_writes(d.quicDispatcher)
+}
+
+// ProcessBufferedChlos starts a new event loop iteration in which at most
+// |maxNewSessions| sessions are created, CHLOs buffered by earlier iterations
+// first. Returns whether CHLOs are still buffered.
+func (d *QuicDispatcher) ProcessBufferedChlos(maxNewSessions int) bool {
+	return C.quic_dispatcher_process_buffered_chlos(d.quicDispatcher, C.size_t(maxNewSessions)) != 0
+}
+
+func (d *QuicDispatcher) HasChlosBuffered() bool {
+	return C.quic_dispatcher_has_chlos_buffered(d.quicDispatcher) != 0
+}
+
+// OnLoopLag reports how long an event (a packet, or a due alarm) waited
+// before the loop got to it. The smoothed lag drives MaxLoopLag.
+func (d *QuicDispatcher) OnLoopLag(lag time.Duration) {
+	C.quic_dispatcher_on_loop_lag(d.quicDispatcher, C.int64_t(lag/time.Microsecond))
+}
+
+// EnableBufferPacketsTillChlo makes every dispatcher buffer packets of unknown
+// connections until their CHLO arrives, as
+// DispatcherConfig.LimitNewSessionsPerLoop requires. The budget itself is
+// given to ProcessBufferedChlos, by QuicSpdyServer from NewSessionsPerLoop.
+// This is a process-wide libquic flag, harmless to dispatchers without a
+// limit.
+func EnableBufferPacketsTillChlo() {
+	C.enable_buffer_packets_till_chlo()
+}
+
+// metrics returns the dispatcher's C++ counters, which may be read from any
+// goroutine with readDispatcherMetrics while the dispatcher is alive.
+func (d *QuicDispatcher) metrics() unsafe.Pointer {
+	return unsafe.Pointer(C.quic_dispatcher_metrics(d.quicDispatcher))
+}
+
+// OnWriterUnblocked lets connections blocked on the server writer send again.
+func (d *QuicDispatcher) OnWriterUnblocked() {
+	C.quic_dispatcher_on_writer_unblocked(d.quicDispatcher)
+}
+
+// Statistics collects connection stats of at most |maxSessions| sessions, in
+// map order, so it stays cheap however many sessions are open. Aggregated
+// counters are available without going through the dispatcher loop; see
+// metrics().
+func (d *QuicDispatcher) Statistics(maxSessions int) DispatcherStatistics {
+	n := len(d.quicServerSessions)
+	if n > maxSessions {
+		n = maxSessions
+	}
+	stat := DispatcherStatistics{SessionStatistics: make([]SessionStatistics, 0, n)}
 	for session, _ := range d.quicServerSessions {
+		if len(stat.SessionStatistics) >= n {
+			break
+		}
 		stat.SessionStatistics = append(stat.SessionStatistics, SessionStatistics{C.quic_server_session_connection_stat(session.quicServerSession)})
 	}
+	C.quic_dispatcher_pool_stats(d.quicDispatcher, &stat.PoolStatistics.Pstat)
 	return stat
 }
 
@@ -88,8 +280,3 @@ func DeleteGoSession(dispatcher_key int64, go_session_key int64) {
 func ReleaseQuicDispatcher(task_runner_key int64) {
 	quicDispatcherPtr.Del(task_runner_key)
 }
-
-//export ReleaseTaskRunner
-func ReleaseTaskRunner(task_runner_key int64) {
-	taskRunnerPtr.Del(task_runner_key)
-}
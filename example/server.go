@@ -130,6 +130,7 @@ func main() {
 	}
 
 	http.Handle("/statistics/json", statisticsHandler(server))
+	http.Handle("/metrics", server.MetricsHandler())
 
 	if err := server.ListenAndServe(); err != nil {
 		log.Fatal(err)
@@ -6,8 +6,8 @@
 
 #include "_cgo_export.h"
 
-void WriteToUDP_C(int64_t go_writer, void* peer_ip, size_t peer_ip_sz, uint16_t peer_port, void* buffer, size_t buf_len) {
-    WriteToUDP(go_writer, peer_ip, peer_ip_sz, peer_port, buffer, buf_len);
+int WriteToUDPBatch_C(int64_t go_writer, struct GoPacketDesc* descs, size_t num_descs, char* buffer, size_t buf_len) {
+    return WriteToUDPBatch(go_writer, descs, num_descs, buffer, buf_len);
 }
 
 void WriteToUDPClient_C(int64_t go_writer, void* peer_ip, size_t peer_ip_sz, uint16_t peer_port, void* buffer, size_t buf_len) {
@@ -26,6 +26,14 @@ int GetProof_C(int64_t go_proof_source, char* server_ip, size_t server_ip_sz, ch
     return GetProof(go_proof_source, server_ip, server_ip_sz, hostname, hostname_sz, server_config, server_config_sz, quic_version, chlo_hash, chlo_hash_len, out_signature, out_signature_sz);
 }
 
+int GetProofAsync_C(int64_t go_proof_source, int64_t go_quic_dispatcher, void* job, char* server_ip, size_t server_ip_sz, char* hostname, size_t hostname_sz, char* server_config, size_t server_config_sz, int quic_version, char* chlo_hash, size_t chlo_hash_len) {
+    return GetProofAsync(go_proof_source, go_quic_dispatcher, job, server_ip, server_ip_sz, hostname, hostname_sz, server_config, server_config_sz, quic_version, chlo_hash, chlo_hash_len);
+}
+
+void ProofSigned_C(int64_t go_quic_dispatcher, void* job) {
+    ProofSigned(go_quic_dispatcher, job);
+}
+
 int64_t CreateIncomingDynamicStream_C(int64_t go_quic_server_session, uint32_t id, void* go_quic_simple_server_stream_go_wrapper) {
     return CreateIncomingDynamicStream(go_quic_server_session, id, go_quic_simple_server_stream_go_wrapper);
 }
@@ -38,26 +46,10 @@ void UnregisterQuicClientStreamFromSession_C(int64_t go_stream) {
     UnregisterQuicClientStreamFromSession(go_stream);
 }
 
-int64_t CreateGoQuicAlarm_C(void* go_quic_alarm_go_wrapper, void* clock, int64_t task_runner) {
-    return CreateGoQuicAlarm(go_quic_alarm_go_wrapper, clock, task_runner);
-}
-
-void GoQuicAlarmSetImpl_C(int64_t go_quic_alarm, int64_t deadline) {
-    GoQuicAlarmSetImpl(go_quic_alarm, deadline);
-}
-
-void GoQuicAlarmCancelImpl_C(int64_t go_quic_alarm) {
-    GoQuicAlarmCancelImpl(go_quic_alarm);
-}
-
-void GoQuicAlarmDestroy_C(int64_t go_quic_alarm) {
-    GoQuicAlarmDestroy(go_quic_alarm);
-}
-
-void GoQuicSpdyClientStreamOnInitialHeadersComplete_C(int64_t go_quic_spdy_client_stream, struct GoSpdyHeader* headers) {
+void GoQuicSpdyClientStreamOnInitialHeadersComplete_C(int64_t go_quic_spdy_client_stream, struct GoHeaderBlock* headers) {
     GoQuicSpdyClientStreamOnInitialHeadersComplete(go_quic_spdy_client_stream, headers);
 }
-void GoQuicSpdyClientStreamOnTrailingHeadersComplete_C(int64_t go_quic_spdy_client_stream, struct GoSpdyHeader* headers) {
+void GoQuicSpdyClientStreamOnTrailingHeadersComplete_C(int64_t go_quic_spdy_client_stream, struct GoHeaderBlock* headers) {
     GoQuicSpdyClientStreamOnTrailingHeadersComplete(go_quic_spdy_client_stream, headers);
 }
 void GoQuicSpdyClientStreamOnDataAvailable_C(int64_t go_quic_spdy_client_stream, const char *data, uint32_t data_len, int is_closed) {
@@ -67,7 +59,7 @@ void GoQuicSpdyClientStreamOnClose_C(int64_t go_quic_spdy_client_stream) {
     GoQuicSpdyClientStreamOnClose(go_quic_spdy_client_stream);
 }
 
-void GoQuicSimpleServerStreamOnInitialHeadersComplete_C(int64_t go_quic_simple_server_stream, struct GoSpdyHeader* headers, const char *peer_address, uint32_t peer_address_len) {
+void GoQuicSimpleServerStreamOnInitialHeadersComplete_C(int64_t go_quic_simple_server_stream, struct GoRequestHeaders* headers, const char *peer_address, uint32_t peer_address_len) {
     GoQuicSimpleServerStreamOnInitialHeadersComplete(go_quic_simple_server_stream, headers, (void *)peer_address, peer_address_len);
 }
 void GoQuicSimpleServerStreamOnDataAvailable_C(int64_t go_quic_simple_server_stream, const char *data, uint32_t data_len, int is_closed) {
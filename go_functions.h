@@ -6,25 +6,22 @@
 #ifdef __cplusplus
 extern "C" {
 #endif
-void WriteToUDP_C(int64_t go_writer, void* peer_ip, size_t peer_ip_sz, uint16_t peer_port, void* buffer, size_t buf_len);
+int WriteToUDPBatch_C(int64_t go_writer, struct GoPacketDesc* descs, size_t num_descs, char* buffer, size_t buf_len);
 void WriteToUDPClient_C(int64_t go_writer, void* peer_ip, size_t peer_ip_sz, uint16_t peer_port, void* buffer, size_t buf_len);
 int64_t CreateGoSession_C(int64_t go_quic_dispatcher, void* quic_server_session);
 void DeleteGoSession_C(int64_t go_quic_dispatcher, int64_t go_quic_server_session);
 int GetProof_C(int64_t go_proof_source, char* server_ip, size_t server_ip_sz, char* hostname, size_t hostname_sz, char* server_config, size_t server_config_sz, int quic_version, char* chlo_hash, size_t chlo_hash_len, char **out_signature, size_t *out_signature_sz);
+int GetProofAsync_C(int64_t go_proof_source, int64_t go_quic_dispatcher, void* job, char* server_ip, size_t server_ip_sz, char* hostname, size_t hostname_sz, char* server_config, size_t server_config_sz, int quic_version, char* chlo_hash, size_t chlo_hash_len);
+void ProofSigned_C(int64_t go_quic_dispatcher, void* job);
 int64_t CreateIncomingDynamicStream_C(int64_t go_quic_server_session, uint32_t id, void* go_quic_simple_server_stream_go_wrapper);
 void UnregisterQuicServerStreamFromSession_C(int64_t go_stream);
 void UnregisterQuicClientStreamFromSession_C(int64_t go_stream);
 
-int64_t CreateGoQuicAlarm_C(void* go_quic_alarm_go_wrapper, void* clock, int64_t go_task_runner);
-void GoQuicAlarmSetImpl_C(int64_t go_quic_alarm, int64_t deadline);
-void GoQuicAlarmCancelImpl_C(int64_t go_quic_alarm);
-void GoQuicAlarmDestroy_C(int64_t go_quic_alarm);
-
-void GoQuicSpdyClientStreamOnInitialHeadersComplete_C(int64_t go_quic_spdy_client_stream, struct GoSpdyHeader* headers);
-void GoQuicSpdyClientStreamOnTrailingHeadersComplete_C(int64_t go_quic_spdy_client_stream, struct GoSpdyHeader* headers);
+void GoQuicSpdyClientStreamOnInitialHeadersComplete_C(int64_t go_quic_spdy_client_stream, struct GoHeaderBlock* headers);
+void GoQuicSpdyClientStreamOnTrailingHeadersComplete_C(int64_t go_quic_spdy_client_stream, struct GoHeaderBlock* headers);
 void GoQuicSpdyClientStreamOnDataAvailable_C(int64_t go_quic_spdy_client_stream, const char *data, uint32_t data_len, int is_closed);
 void GoQuicSpdyClientStreamOnClose_C(int64_t go_quic_spdy_client_stream);
-void GoQuicSimpleServerStreamOnInitialHeadersComplete_C(int64_t go_quic_spdy_client_stream, struct GoSpdyHeader* headers, const char *peer_address, uint32_t peer_address_len);
+void GoQuicSimpleServerStreamOnInitialHeadersComplete_C(int64_t go_quic_spdy_client_stream, struct GoRequestHeaders* headers, const char *peer_address, uint32_t peer_address_len);
 void GoQuicSimpleServerStreamOnDataAvailable_C(int64_t go_quic_simple_server_stream, const char *data, uint32_t data_len, int is_closed);
 void GoQuicSimpleServerStreamOnClose_C(int64_t go_quic_simple_server_stream);
 
@@ -75,14 +75,117 @@ struct GoQuicServerConfig {
   int Num_of_keys;
 };
 
-struct GoSpdyHeader {
-  int N;  // Size of header
-  int* Keys_len;   // Length of each keys in header
-  int* Values_len; // Length of each values in header
-
-  // Used on C side to pass headers to Go.
-  const char** Keys;
-  const char** Values;
+// Header block passed from C++ to Go, packed into one buffer: Lens holds
+// the lengths of key 0, value 0, key 1, value 1, ... and Data the same
+// strings back to back.
+struct GoHeaderBlock {
+  int N;  // Number of headers
+  const uint32_t* Lens;
+  const char* Data;
+  size_t Data_len;
+};
+
+// Request header block with the pseudo-headers moved out of Headers. Their
+// values come first in Headers.Data, in field order, followed by the regular
+// headers described by Headers.Lens. A length of -1 means missing.
+struct GoRequestHeaders {
+  struct GoHeaderBlock Headers;
+  int32_t Method_len;
+  int32_t Path_len;
+  int32_t Authority_len;
+  int32_t Scheme_len;
+  int32_t Version_len;
+};
+
+// Per-dispatcher settings passed to create_quic_dispatcher().
+struct GoQuicDispatcherConfig {
+  // Connection IDs chosen by this dispatcher satisfy
+  // (uint32_t)id % Num_shards == Shard_index.
+  uint32_t Shard_index;
+  uint32_t Num_shards;
+
+  // If non-zero, Server_id is stored in the top 16 bits of connection IDs
+  // chosen by this dispatcher.
+  int Use_server_id;
+  uint16_t Server_id;
+
+  // Size limit of the time-wait list. Zero keeps
+  // FLAGS_quic_time_wait_list_max_connections; negative means unlimited.
+  int32_t Time_wait_max_connections;
+
+  // If non-zero, new sessions are only created within the budget given to
+  // quic_dispatcher_process_buffered_chlos() for each event loop iteration.
+  int Limit_new_sessions_per_loop;
+
+  // Admission control of new connections. Zero disables each check.
+  uint32_t Max_sessions;         // Open sessions of this dispatcher
+  int64_t Max_loop_lag_us;       // Smoothed event loop lag
+  double Chlo_rate_per_prefix;   // CHLOs per second per /24 or /48 prefix
+  double Chlo_burst_per_prefix;  // Defaults to Chlo_rate_per_prefix
+
+  // Packets per second from one IPv4 address or IPv6 /56 which do not belong
+  // to an open session. Checked before the packet is parsed; zero disables.
+  double Unknown_packet_rate_per_source;
+  double Unknown_packet_burst_per_source;  // Defaults to the rate
+};
+
+// Scheduling state of a GoQuicTimerWheel, read by Go without calling into
+// C++. Times are QuicClock microseconds.
+struct GoQuicTimerWheelState {
+  int64_t Now;  // Clock time at the last FireExpired() call
+
+  // No later than the earliest scheduled deadline; INT64_MAX if there is
+  // nothing scheduled.
+  int64_t Next_deadline;
+};
+
+// Describes one datagram inside a buffer shared by a batch of packets.
+struct GoPacketDesc {
+  uint8_t Peer_ip[16];  // Packed IPv4 (4 bytes) or IPv6 (16 bytes) address
+  int Peer_ip_len;
+  uint16_t Peer_port;
+
+  size_t Offset;  // Offset of the datagram in the shared buffer
+  size_t Length;
+
+  // Receive time in UNIX microseconds. Zero means "when processed".
+  int64_t Timestamp;
+};
+
+// Snapshot of the counters of one dispatcher (GoQuicDispatcherMetrics).
+// Everything but the last two fields counts events since the dispatcher was
+// created.
+struct GoQuicDispatcherStats {
+  uint64_t Packets_received;
+  uint64_t Packets_sent;  // Including time-wait and version negotiation
+  uint64_t Sessions_created;
+  uint64_t Sessions_closed;
+  uint64_t Chlos_buffered;  // CHLOs held back by the per-loop session limit
+  uint64_t Stateless_rejects;
+  uint64_t Version_negotiations;
+  uint64_t Write_blocks;  // Times the egress queue reported itself full
+  uint64_t Alarms_fired;
+  uint64_t Chlos_shed;  // CHLOs turned away by the admission policy
+  uint64_t Packets_rate_limited;  // Dropped before parsing, per source limit
+
+  uint64_t Sessions;  // Currently open
+  uint64_t Time_wait_connections;
+  uint64_t Loop_lag_us;  // Smoothed event loop lag
+};
+
+// Occupancy of one per-dispatcher object pool.
+struct GoQuicPoolStat {
+  int64_t Live;         // Objects currently handed out
+  int64_t Free;         // Objects ready to be reused
+  int64_t Allocations;  // Allocations served from the pool so far
+};
+
+struct GoQuicPoolStats {
+  struct GoQuicPoolStat Connections;
+  struct GoQuicPoolStat Writers;  // Per-connection packet writers
+  struct GoQuicPoolStat Sessions;
+  struct GoQuicPoolStat Streams;
+  struct GoQuicPoolStat Bodies;  // Request body buffers
 };
 
 typedef int64_t GoPtr;
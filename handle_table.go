@@ -0,0 +1,147 @@
+package goquic
+
+import (
+	"sync"
+	"sync/atomic"
+	"unsafe"
+)
+
+const (
+	handleChunkBits = 10
+	handleChunkSize = 1 << handleChunkBits
+	maxHandleChunks = 1024 // Up to 1M live handles per table
+
+	handleGenerationMask = 0x7fffffff // Keeps handles positive
+)
+
+type handleSlot struct {
+	ptr  unsafe.Pointer
+	gen  uint32
+	next uint32 // Free list link: index of the next free slot + 1, or 0
+}
+
+type handleChunk [handleChunkSize]handleSlot
+
+// handleTable maps int64 handles that are passed through C++ back to Go
+// objects. A handle is generation<<32 | slot index. Get is lock-free and
+// returns nil for handles whose slot has been released (and possibly
+// reused) since, so stale handles are detected instead of aliasing a new
+// object. Released slots are recycled through a lock-free free list; the
+// mutex is only taken when a new chunk of slots has to be allocated.
+//
+// Generations start at 1, so 0 is never a valid handle.
+type handleTable struct {
+	chunks [maxHandleChunks]unsafe.Pointer // *handleChunk
+	grow   sync.Mutex
+
+	allocated uint32 // Number of slots ever handed out
+
+	// Top of the free list: ABA tag in the high 32 bits, index + 1 of the
+	// first free slot in the low 32 bits.
+	freeHead uint64
+}
+
+func (t *handleTable) slot(index uint32) *handleSlot {
+	chunk := (*handleChunk)(atomic.LoadPointer(&t.chunks[index>>handleChunkBits]))
+	if chunk == nil {
+		return nil
+	}
+	return &chunk[index&(handleChunkSize-1)]
+}
+
+func (t *handleTable) get(handle int64) unsafe.Pointer {
+	index := uint32(handle)
+	gen := uint32(handle >> 32)
+	if index>>handleChunkBits >= maxHandleChunks {
+		return nil
+	}
+	s := t.slot(index)
+	if s == nil || atomic.LoadUint32(&s.gen) != gen {
+		return nil
+	}
+	p := atomic.LoadPointer(&s.ptr)
+	// del() bumps the generation before clearing the pointer, so an
+	// unchanged generation means |p| belongs to this handle.
+	if atomic.LoadUint32(&s.gen) != gen {
+		return nil
+	}
+	return p
+}
+
+func (t *handleTable) set(p unsafe.Pointer) int64 {
+	index := t.popFree()
+	s := t.slot(index)
+	atomic.StorePointer(&s.ptr, p)
+	return int64(atomic.LoadUint32(&s.gen))<<32 | int64(index)
+}
+
+func (t *handleTable) del(handle int64) {
+	index := uint32(handle)
+	gen := uint32(handle >> 32)
+	if index>>handleChunkBits >= maxHandleChunks {
+		return
+	}
+	s := t.slot(index)
+	if s == nil {
+		return
+	}
+
+	next := (gen + 1) & handleGenerationMask
+	if next == 0 {
+		next = 1
+	}
+	if !atomic.CompareAndSwapUint32(&s.gen, gen, next) {
+		// Already released.
+		return
+	}
+	atomic.StorePointer(&s.ptr, nil)
+	t.pushFree(index)
+}
+
+func (t *handleTable) popFree() uint32 {
+	for {
+		head := atomic.LoadUint64(&t.freeHead)
+		first := uint32(head)
+		if first == 0 {
+			return t.allocate()
+		}
+		next := atomic.LoadUint32(&t.slot(first - 1).next)
+		newHead := (head>>32+1)<<32 | uint64(next)
+		if atomic.CompareAndSwapUint64(&t.freeHead, head, newHead) {
+			return first - 1
+		}
+	}
+}
+
+func (t *handleTable) pushFree(index uint32) {
+	s := t.slot(index)
+	for {
+		head := atomic.LoadUint64(&t.freeHead)
+		atomic.StoreUint32(&s.next, uint32(head))
+		newHead := (head>>32+1)<<32 | uint64(index+1)
+		if atomic.CompareAndSwapUint64(&t.freeHead, head, newHead) {
+			return
+		}
+	}
+}
+
+func (t *handleTable) allocate() uint32 {
+	index := atomic.AddUint32(&t.allocated, 1) - 1
+	c := index >> handleChunkBits
+	if c >= maxHandleChunks {
+		panic("goquic: handle table is full")
+	}
+
+	if atomic.LoadPointer(&t.chunks[c]) == nil {
+		t.grow.Lock()
+		if atomic.LoadPointer(&t.chunks[c]) == nil {
+			chunk := new(handleChunk)
+			for i := range chunk {
+				chunk[i].gen = 1
+			}
+			atomic.StorePointer(&t.chunks[c], unsafe.Pointer(chunk))
+		}
+		t.grow.Unlock()
+	}
+	return index
+}
@@ -0,0 +1,81 @@
+package goquic
+
+import (
+	"net/http"
+	"strings"
+)
+
+// Header names as they appear on the wire (lower case). Received header
+// blocks use these strings as map keys, and outgoing http.Header keys are
+// mapped back to them without allocating.
+var commonHeaderNames = []string{
+	":authority", ":method", ":path", ":scheme", ":status", ":version",
+	"accept", "accept-charset", "accept-encoding", "accept-language",
+	"accept-ranges", "access-control-allow-origin", "age", "allow",
+	"alt-svc", "alternate-protocol", "authorization", "cache-control",
+	"connection", "content-disposition", "content-encoding",
+	"content-language", "content-length", "content-location",
+	"content-range", "content-type", "cookie", "date", "etag", "expect",
+	"expires", "from", "host", "if-match", "if-modified-since",
+	"if-none-match", "if-range", "if-unmodified-since", "last-modified",
+	"link", "location", "max-forwards", "origin", "pragma",
+	"proxy-authenticate", "proxy-authorization", "range", "referer",
+	"refresh", "retry-after", "server", "set-cookie",
+	"strict-transport-security", "te", "trailer", "transfer-encoding",
+	"upgrade", "user-agent", "vary", "via", "www-authenticate",
+	"x-content-type-options", "x-forwarded-for", "x-forwarded-proto",
+	"x-frame-options", "x-requested-with", "x-xss-protection",
+}
+
+var (
+	internedHeaderNames = make(map[string]string, len(commonHeaderNames))
+
+	// Canonical (http.CanonicalHeaderKey) and wire form -> wire form
+	wireHeaderNames = make(map[string]string, 2*len(commonHeaderNames))
+
+	// Wire form -> canonical form
+	canonicalHeaderNames = make(map[string]string, len(commonHeaderNames))
+)
+
+func init() {
+	for _, name := range commonHeaderNames {
+		internedHeaderNames[name] = name
+		wireHeaderNames[name] = name
+		if name[0] != ':' {
+			canonical := http.CanonicalHeaderKey(name)
+			wireHeaderNames[canonical] = name
+			canonicalHeaderNames[name] = canonical
+		}
+	}
+}
+
+// internHeaderName returns the shared copy of |name| if it is a common one.
+func internHeaderName(name string) string {
+	if s, ok := internedHeaderNames[name]; ok {
+		return s
+	}
+	return name
+}
+
+// canonicalHeaderName is http.CanonicalHeaderKey, without allocating for
+// common names.
+func canonicalHeaderName(name string) string {
+	if s, ok := canonicalHeaderNames[name]; ok {
+		return s
+	}
+	return http.CanonicalHeaderKey(name)
+}
+
+// wireHeaderName lower-cases |name|, without allocating for common or already
+// lower-case names.
+func wireHeaderName(name string) string {
+	if s, ok := wireHeaderNames[name]; ok {
+		return s
+	}
+	for i := 0; i < len(name); i++ {
+		if c := name[i]; 'A' <= c && c <= 'Z' {
+			return strings.ToLower(name)
+		}
+	}
+	return name
+}
@@ -0,0 +1,100 @@
+package goquic
+
+// #include <stddef.h>
+// #include "src/adaptor.h"
+import "C"
+import (
+	"bufio"
+	"io"
+	"net/http"
+	"strconv"
+	"sync/atomic"
+	"unsafe"
+)
+
+// DispatcherMetrics is a snapshot of the aggregated counters of one
+// dispatcher.
+type DispatcherMetrics struct {
+	Shard int // Index of the dispatcher
+	Mstat C.struct_GoQuicDispatcherStats
+}
+
+func readDispatcherMetrics(shard int, metrics unsafe.Pointer) DispatcherMetrics {
+	m := DispatcherMetrics{Shard: shard}
+	C.quic_dispatcher_metrics_snapshot(metrics, &m.Mstat)
+	return m
+}
+
+// Metrics returns the counters of every running dispatcher, skipping those
+// not started yet. Unlike Statistics, it never waits for the dispatcher loops.
+func (srv *QuicSpdyServer) Metrics() []DispatcherMetrics {
+	metrics := make([]DispatcherMetrics, 0, len(srv.dispatcherMetrics))
+	for i := range srv.dispatcherMetrics {
+		if p := atomic.LoadPointer(&srv.dispatcherMetrics[i]); p != nil {
+			metrics = append(metrics, readDispatcherMetrics(i, p))
+		}
+	}
+	return metrics
+}
+
+type metricDesc struct {
+	name  string
+	kind  string
+	help  string
+	value func(m *C.struct_GoQuicDispatcherStats) uint64
+}
+
+var dispatcherMetricDescs = []metricDesc{
+	{"goquic_packets_received_total", "counter", "Packets handed to the dispatcher.",
+		func(m *C.struct_GoQuicDispatcherStats) uint64 { return uint64(m.Packets_received) }},
+	{"goquic_packets_sent_total", "counter", "Packets written by the dispatcher and its connections.",
+		func(m *C.struct_GoQuicDispatcherStats) uint64 { return uint64(m.Packets_sent) }},
+	{"goquic_sessions_created_total", "counter", "Sessions created.",
+		func(m *C.struct_GoQuicDispatcherStats) uint64 { return uint64(m.Sessions_created) }},
+	{"goquic_sessions_closed_total", "counter", "Sessions closed.",
+		func(m *C.struct_GoQuicDispatcherStats) uint64 { return uint64(m.Sessions_closed) }},
+	{"goquic_chlos_buffered_total", "counter", "CHLOs buffered until the next event loop.",
+		func(m *C.struct_GoQuicDispatcherStats) uint64 { return uint64(m.Chlos_buffered) }},
+	{"goquic_stateless_rejects_total", "counter", "Handshakes rejected statelessly.",
+		func(m *C.struct_GoQuicDispatcherStats) uint64 { return uint64(m.Stateless_rejects) }},
+	{"goquic_version_negotiations_total", "counter", "Version negotiation packets sent.",
+		func(m *C.struct_GoQuicDispatcherStats) uint64 { return uint64(m.Version_negotiations) }},
+	{"goquic_write_blocks_total", "counter", "Times the egress queue blocked the writer.",
+		func(m *C.struct_GoQuicDispatcherStats) uint64 { return uint64(m.Write_blocks) }},
+	{"goquic_alarms_fired_total", "counter", "QUIC alarms fired.",
+		func(m *C.struct_GoQuicDispatcherStats) uint64 { return uint64(m.Alarms_fired) }},
+	{"goquic_chlos_shed_total", "counter", "CHLOs turned away by admission control.",
+		func(m *C.struct_GoQuicDispatcherStats) uint64 { return uint64(m.Chlos_shed) }},
+	{"goquic_packets_rate_limited_total", "counter", "Packets for unknown connections dropped by the per-source limit.",
+		func(m *C.struct_GoQuicDispatcherStats) uint64 { return uint64(m.Packets_rate_limited) }},
+	{"goquic_sessions", "gauge", "Open sessions.",
+		func(m *C.struct_GoQuicDispatcherStats) uint64 { return uint64(m.Sessions) }},
+	{"goquic_time_wait_connections", "gauge", "Connection IDs in time-wait state.",
+		func(m *C.struct_GoQuicDispatcherStats) uint64 { return uint64(m.Time_wait_connections) }},
+	{"goquic_loop_lag_microseconds", "gauge", "Smoothed time events wait for the dispatcher loop.",
+		func(m *C.struct_GoQuicDispatcherStats) uint64 { return uint64(m.Loop_lag_us) }},
+}
+
+// WriteMetrics writes the dispatcher counters in the Prometheus text
+// exposition format, labelled by dispatcher shard.
+func (srv *QuicSpdyServer) WriteMetrics(w io.Writer) error {
+	metrics := srv.Metrics()
+	bw := bufio.NewWriter(w)
+	for _, desc := range dispatcherMetricDescs {
+		bw.WriteString("# HELP " + desc.name + " " + desc.help + "\n")
+		bw.WriteString("# TYPE " + desc.name + " " + desc.kind + "\n")
+		for i := range metrics {
+			bw.WriteString(desc.name + `{dispatcher="` + strconv.Itoa(metrics[i].Shard) + `"} `)
+			bw.WriteString(strconv.FormatUint(desc.value(&metrics[i].Mstat), 10) + "\n")
+		}
+	}
+	return bw.Flush()
+}
+
+// MetricsHandler serves WriteMetrics, for scraping by Prometheus.
+func (srv *QuicSpdyServer) MetricsHandler() http.Handler {
+	return http.HandlerFunc(func(w http.ResponseWriter, r *http.Request) {
+		w.Header().Set("Content-Type", "text/plain; version=0.0.4")
+		srv.WriteMetrics(w)
+	})
+}
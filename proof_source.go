@@ -12,17 +12,74 @@ import (
 	"crypto/tls"
 	"crypto/x509"
 	"encoding/binary"
+	"errors"
 	"net"
 	"unsafe"
 )
 
+// Signing jobs that may be queued per worker. Beyond that GetProof signs on
+// the dispatcher thread.
+const proofJobQueueSize = 64
+
 type ProofSource struct {
 	Certificate   tls.Certificate
 	proofSource_c unsafe.Pointer
+	jobs          chan *proofJob // nil unless workers are running
+	nativeSigning bool
+}
+
+type proofJob struct {
+	job_c        unsafe.Pointer
+	dispatcher   *QuicDispatcher
+	quicVersion  int
+	serverIp     net.IP
+	hostname     []byte
+	serverConfig []byte
+	chloHash     []byte
+}
+
+// StartWorkers moves proof signing off the dispatcher threads onto |n|
+// goroutines, or with native signing onto |n| C++ threads which never call
+// into Go to sign. Signed proofs are handed back to the dispatcher which asked
+// for them. This switches libquic to asynchronous GetProof for the whole
+// process.
+func (ps *ProofSource) StartWorkers(n int) {
+	if ps.nativeSigning {
+		C.proof_source_goquic_start_signing_threads(ps.proofSource_c, C.int(n))
+	} else {
+		ps.jobs = make(chan *proofJob, n*proofJobQueueSize)
+		for i := 0; i < n; i++ {
+			go ps.signLoop()
+		}
+	}
+	C.set_async_get_proof(1)
+}
+
+func (ps *ProofSource) signLoop() {
+	for job := range ps.jobs {
+		job := job
+		sig, err := ps.sign(job.quicVersion, job.serverConfig, job.chloHash)
+		job.dispatcher.proofDone <- func() {
+			if err != nil || len(sig) == 0 {
+				// Fails the handshake rather than the dispatcher.
+				C.proof_source_goquic_complete_get_proof(job.job_c, 0, nil, 0)
+				return
+			}
+			C.proof_source_goquic_complete_get_proof(job.job_c, 1, (*C.char)(unsafe.Pointer(&sig[0])), C.size_t(len(sig)))
+		}
+	}
 }
 
 func (ps *ProofSource) GetProof(quicVersion int, addr net.IP, hostname []byte, serverConfig []byte, chloHash []byte) (outSignature []byte) {
-	var err error = nil
+	outSignature, err := ps.sign(quicVersion, serverConfig, chloHash)
+	if err != nil {
+		panic(err)
+	}
+	return outSignature
+}
+
+// sign is GetProof, reporting failures instead of panicking.
+func (ps *ProofSource) sign(quicVersion int, serverConfig []byte, chloHash []byte) ([]byte, error) {
 	var bufferToSign *bytes.Buffer
 
 	if quicVersion > 30 {
@@ -41,34 +98,23 @@ func (ps *ProofSource) GetProof(quicVersion int, addr net.IP, hostname []byte, s
 	}
 
 	hasher := crypto.SHA256.New()
-	_, err = hasher.Write(bufferToSign.Bytes())
-	if err != nil {
-		panic("Error while hashing")
+	if _, err := hasher.Write(bufferToSign.Bytes()); err != nil {
+		return nil, err
 	}
 	hashSum := hasher.Sum(nil)
 
 	switch priv := ps.Certificate.PrivateKey.(type) {
 	case *rsa.PrivateKey:
-		outSignature, err = priv.Sign(rand.Reader, hashSum, &rsa.PSSOptions{SaltLength: rsa.PSSSaltLengthEqualsHash, Hash: crypto.SHA256})
-		if err != nil {
-			panic(err)
-		}
+		return priv.Sign(rand.Reader, hashSum, &rsa.PSSOptions{SaltLength: rsa.PSSSaltLengthEqualsHash, Hash: crypto.SHA256})
 	case *ecdsa.PrivateKey:
 		// XXX(serialx): Not tested. Should input be a hashSum or the original message?
 		//               Since there is no secure QUIC server reference implementation,
 		//               only a real test with the Chrome browser would verify the code.
 		//               Since I don't currently have a ECDSA certificate, no testing is done.
-		outSignature, err = priv.Sign(rand.Reader, hashSum, nil)
-		if err != nil {
-			panic(err)
-		}
+		return priv.Sign(rand.Reader, hashSum, nil)
 	default:
-		panic("Unknown form of private key")
-	}
-	if err != nil {
-		panic(err)
+		return nil, errors.New("goquic: unknown form of private key")
 	}
-	return outSignature
 }
 
 func NewProofSource(cert tls.Certificate) *ProofSource {
@@ -92,6 +138,44 @@ func NewProofSource(cert tls.Certificate) *ProofSource {
 	return ps
 }
 
+// UseNativeSigning hands the certificate's private key over to C++, which then
+// signs proofs with BoringSSL instead of calling back into Go. RSA and ECDSA
+// (e.g. P-256) keys are supported. Must be called before the ProofSource is
+// used by a crypto config.
+func (ps *ProofSource) UseNativeSigning() error {
+	var der []byte
+	var err error
+	switch priv := ps.Certificate.PrivateKey.(type) {
+	case *rsa.PrivateKey:
+		der = x509.MarshalPKCS1PrivateKey(priv)
+	case *ecdsa.PrivateKey:
+		der, err = x509.MarshalECPrivateKey(priv)
+		if err != nil {
+			return err
+		}
+	default:
+		return errors.New("goquic: unsupported private key type for native signing")
+	}
+
+	ok := C.proof_source_goquic_set_private_key(ps.proofSource_c, (*C.char)(unsafe.Pointer(&der[0])), C.size_t(len(der)))
+	for i := range der {
+		der[i] = 0
+	}
+	if ok == 0 {
+		return errors.New("goquic: BoringSSL rejected the private key")
+	}
+	ps.nativeSigning = true
+	return nil
+}
+
+// SignatureCacheStats reports how many GetProof calls were answered from the
+// C++ signature cache, and how many had to be signed.
+func (ps *ProofSource) SignatureCacheStats() (hits, misses uint64) {
+	var hits_c, misses_c C.uint64_t
+	C.proof_source_goquic_get_signature_cache_stats(ps.proofSource_c, &hits_c, &misses_c)
+	return uint64(hits_c), uint64(misses_c)
+}
+
 //export GetProof
 func GetProof(proof_source_key int64,
 	server_ip_c unsafe.Pointer, server_ip_sz C.size_t,
@@ -103,12 +187,13 @@ func GetProof(proof_source_key int64,
 
 	proofSource := proofSourcePtr.Get(proof_source_key)
 
-	serverIp := net.IP(C.GoBytes(server_ip_c, C.int(server_ip_sz)))
-	hostname := C.GoBytes(hostname_c, C.int(hostname_sz_c))
 	serverConfig := C.GoBytes(server_config_c, C.int(server_config_sz_c))
 	chloHash := C.GoBytes(chlo_hash_c, C.int(chlo_hash_sz))
 
-	sig := proofSource.GetProof(quicVersion, serverIp, hostname, serverConfig, chloHash)
+	sig, err := proofSource.sign(quicVersion, serverConfig, chloHash)
+	if err != nil || len(sig) == 0 {
+		return C.int(0)
+	}
 
 	*out_signature_c = C.CString(string(sig)) // Must free C string
 	*out_signature_sz_c = C.size_t(len(sig))
@@ -116,6 +201,53 @@ func GetProof(proof_source_key int64,
 	return C.int(1)
 }
 
+//export GetProofAsync
+func GetProofAsync(proof_source_key int64, dispatcher_key int64, job_c unsafe.Pointer,
+	server_ip_c unsafe.Pointer, server_ip_sz C.size_t,
+	hostname_c unsafe.Pointer, hostname_sz_c C.size_t,
+	server_config_c unsafe.Pointer, server_config_sz_c C.size_t,
+	quicVersion int,
+	chlo_hash_c unsafe.Pointer, chlo_hash_sz C.size_t) C.int {
+
+	proofSource := proofSourcePtr.Get(proof_source_key)
+	dispatcher := quicDispatcherPtr.Get(dispatcher_key)
+	if proofSource == nil || proofSource.jobs == nil || dispatcher == nil {
+		return C.int(0)
+	}
+
+	job := &proofJob{
+		job_c:        job_c,
+		dispatcher:   dispatcher,
+		quicVersion:  quicVersion,
+		serverIp:     net.IP(C.GoBytes(server_ip_c, C.int(server_ip_sz))),
+		hostname:     C.GoBytes(hostname_c, C.int(hostname_sz_c)),
+		serverConfig: C.GoBytes(server_config_c, C.int(server_config_sz_c)),
+		chloHash:     C.GoBytes(chlo_hash_c, C.int(chlo_hash_sz)),
+	}
+
+	select {
+	case proofSource.jobs <- job:
+		return C.int(1)
+	default:
+		return C.int(0) // Workers are saturated
+	}
+}
+
+// ProofSigned is called by a native signing thread once it has signed a job,
+// which is then completed on the loop of the dispatcher that issued it.
+//
+//export ProofSigned
+func ProofSigned(dispatcher_key int64, job_c unsafe.Pointer) {
+	dispatcher := quicDispatcherPtr.Get(dispatcher_key)
+	if dispatcher == nil {
+		// Shut down; the job must not be completed off its thread.
+		return
+	}
+	dispatcher.proofDone <- func() {
+		C.proof_source_goquic_complete_signed_proof(job_c)
+	}
+}
+
 //export ReleaseProofSource
 func ReleaseProofSource(proof_source_key int64) {
 	proofSourcePtr.Del(proof_source_key)
@@ -8,8 +8,7 @@ HEADER = Template('''\
 package goquic
 
 import (
-	"sync"
-	"math"
+	"unsafe"
 )
 
 // Generated by `ptr_gen.py ${args}`
@@ -19,41 +18,22 @@ import (
 ''')
 
 TMPL = Template('''\
-var ${inst}Ptr = &${cls}Ptr{pool: make(map[int64]*${cls})}
+var ${inst}Ptr = &${cls}Ptr{}
 
 type ${cls}Ptr struct {
-	sync.RWMutex
-	pool  map[int64]*${cls}
-	index int64
+	table handleTable
 }
 
 func (p *${cls}Ptr) Get(key int64) *${cls} {
-	p.RLock()
-	defer p.RUnlock()
-	return p.pool[key]
+	return (*${cls})(p.table.get(key))
 }
 
 func (p *${cls}Ptr) Set(pt *${cls}) int64 {
-	p.Lock()
-	defer p.Unlock()
-	for {
-		if _, ok := p.pool[p.index]; !ok {
-			break
-		}
-		p.index += 1
-		if p.index == math.MaxInt64 {
-			p.index = 0
-		}
-	}
-	p.pool[p.index] = pt
-	p.index += 1
-	return p.index - 1
+	return p.table.set(unsafe.Pointer(pt))
 }
 
 func (p *${cls}Ptr) Del(key int64) {
-	p.Lock()
-	defer p.Unlock()
-	delete(p.pool, key)
+	p.table.del(key)
 }
 
 ''')
@@ -54,3 +54,31 @@ func (stream *QuicServerStream) WriteTrailers(header http.Header) {
 }
 
 // TODO(hodduc): delete(stream.session.quicServerStreams, stream)
+
+func (stream *QuicServerStream) EnableBodyStreaming() {
+	C.quic_simple_server_stream_enable_body_streaming(stream.wrapper)
+}
+
+func (stream *QuicServerStream) MarkBodyConsumed(n int) {
+	C.quic_simple_server_stream_mark_body_consumed(stream.wrapper, C.size_t(n))
+}
+
+func (stream *QuicServerStream) StopReadingBody() {
+	C.quic_simple_server_stream_stop_reading_body(stream.wrapper)
+}
+
+// WriteSideClosed reports whether a response, such as an error response sent
+// by the C++ stream itself, has already been completed.
+func (stream *QuicServerStream) WriteSideClosed() bool {
+	return C.quic_simple_server_stream_write_side_closed(stream.wrapper) != 0
+}
+
+// WriteBodyBuffer passes ownership of |buf|, which must have been allocated
+// with C.malloc, to the stream.
+func (stream *QuicServerStream) WriteBodyBuffer(buf unsafe.Pointer, n int, fin bool) {
+	fin_int := C.int(0)
+	if fin {
+		fin_int = C.int(1)
+	}
+	C.quic_simple_server_stream_write_body_buffer(stream.wrapper, (*C.char)(buf), C.size_t(n), fin_int)
+}
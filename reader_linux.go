@@ -0,0 +1,221 @@
+package goquic
+
+// #include <sys/syscall.h>
+import "C"
+import (
+	"net"
+	"syscall"
+	"unsafe"
+)
+
+const (
+	udpGRO = 104 // UDP_GRO, Linux 5.0+
+
+	maxRecvmmsgBatch = 64
+	groBufferSize    = 65535
+)
+
+// batchUDPReader receives up to maxRecvmmsgBatch datagrams per recvmmsg call
+// and records the kernel receive timestamp of each one. When the kernel
+// supports UDP_GRO, coalesced datagrams are split back into one UdpData per
+// segment.
+type batchUDPReader struct {
+	conn    *net.UDPConn
+	raw     syscall.RawConn
+	bufpool *BytesBufferPool
+
+	useMmsg bool
+	useGRO  bool
+
+	msgs  []mmsghdr
+	iovs  []syscall.Iovec
+	names []syscall.RawSockaddrInet6
+	oob   []byte
+	bufs  [][]byte // Receive buffer of each message
+
+	oobSpace int
+}
+
+func newBatchUDPReader(conn *net.UDPConn, bufpool *BytesBufferPool) *batchUDPReader {
+	r := &batchUDPReader{
+		conn:     conn,
+		bufpool:  bufpool,
+		msgs:     make([]mmsghdr, maxRecvmmsgBatch),
+		iovs:     make([]syscall.Iovec, maxRecvmmsgBatch),
+		names:    make([]syscall.RawSockaddrInet6, maxRecvmmsgBatch),
+		bufs:     make([][]byte, maxRecvmmsgBatch),
+		oobSpace: syscall.CmsgSpace(int(unsafe.Sizeof(syscall.Timespec{}))) + syscall.CmsgSpace(4),
+	}
+	r.oob = make([]byte, maxRecvmmsgBatch*r.oobSpace)
+
+	raw, err := conn.SyscallConn()
+	if err != nil {
+		return r
+	}
+	r.raw = raw
+	r.useMmsg = true
+
+	raw.Control(func(fd uintptr) {
+		// Both options are best effort: without them packets are stamped at
+		// processing time and GRO is simply not used.
+		syscall.SetsockoptInt(int(fd), syscall.SOL_SOCKET, syscall.SO_TIMESTAMPNS, 1)
+		if syscall.SetsockoptInt(int(fd), solUDP, udpGRO, 1) == nil {
+			r.useGRO = true
+		}
+	})
+
+	if r.useGRO {
+		// Coalesced datagrams may be much larger than a pool buffer, so GRO
+		// receives into private buffers and copies each segment out.
+		for i := range r.bufs {
+			r.bufs[i] = make([]byte, groBufferSize)
+		}
+	}
+	return r
+}
+
+// ReadBatch blocks until at least one datagram is available and appends
+// everything received to |dst|. Buffers of returned UdpData come from the
+// buffer pool.
+func (r *batchUDPReader) ReadBatch(dst []UdpData) ([]UdpData, error) {
+	if !r.useMmsg {
+		return r.readOne(dst)
+	}
+
+	for i := range r.msgs {
+		if r.bufs[i] == nil {
+			// Slots handed out by the previous call need a fresh buffer.
+			r.bufs[i] = r.bufpool.Get()
+		}
+		iov := &r.iovs[i]
+		iov.Base = &r.bufs[i][0]
+		iov.SetLen(len(r.bufs[i]))
+
+		oob := r.oob[i*r.oobSpace : (i+1)*r.oobSpace]
+		msg := &r.msgs[i]
+		*msg = mmsghdr{}
+		msg.Hdr.Name = (*byte)(unsafe.Pointer(&r.names[i]))
+		msg.Hdr.Namelen = syscall.SizeofSockaddrInet6
+		msg.Hdr.Iov = iov
+		setIovlen(&msg.Hdr, 1)
+		msg.Hdr.Control = &oob[0]
+		msg.Hdr.SetControllen(len(oob))
+	}
+
+	var received int
+	var errno syscall.Errno
+	err := r.raw.Read(func(fd uintptr) bool {
+		n, _, e := syscall.Syscall6(uintptr(C.SYS_recvmmsg), fd,
+			uintptr(unsafe.Pointer(&r.msgs[0])), uintptr(len(r.msgs)), 0, 0, 0)
+		if e == syscall.EAGAIN || e == syscall.EINTR {
+			return false
+		}
+		received, errno = int(n), e
+		return true
+	})
+	if err == nil && errno != 0 {
+		err = errno
+	}
+	if err != nil {
+		if errno == syscall.ENOSYS {
+			r.useMmsg = false
+			return r.readOne(dst)
+		}
+		return dst, err
+	}
+
+	for i := 0; i < received; i++ {
+		msg := &r.msgs[i]
+		n := int(msg.Len)
+		addr := sockaddrToUDPAddr(&r.names[i])
+		if n == 0 || addr == nil {
+			continue
+		}
+
+		oob := r.oob[i*r.oobSpace : i*r.oobSpace+int(msg.Hdr.Controllen)]
+		timestamp, segmentSize := parseReceiveCmsgs(oob)
+
+		if !r.useGRO {
+			dst = append(dst, UdpData{Addr: addr, Buf: r.bufs[i], N: n, Timestamp: timestamp})
+			r.bufs[i] = nil
+			continue
+		}
+
+		if segmentSize <= 0 {
+			segmentSize = n
+		}
+		for off := 0; off < n; off += segmentSize {
+			end := off + segmentSize
+			if end > n {
+				end = n
+			}
+			buf := r.bufpool.Get()
+			if len(buf) < end-off {
+				buf = make([]byte, end-off)
+			}
+			copy(buf, r.bufs[i][off:end])
+			dst = append(dst, UdpData{Addr: addr, Buf: buf, N: end - off, Timestamp: timestamp})
+		}
+	}
+
+	return dst, nil
+}
+
+func (r *batchUDPReader) readOne(dst []UdpData) ([]UdpData, error) {
+	buf := r.bufpool.Get()
+	n, peer_addr, err := r.conn.ReadFromUDP(buf)
+	if err != nil {
+		r.bufpool.Put(buf)
+		return dst, err
+	}
+	return append(dst, UdpData{Addr: peer_addr, Buf: buf, N: n}), nil
+}
+
+// parseReceiveCmsgs extracts the SO_TIMESTAMPNS receive time (in UNIX
+// microseconds) and the UDP_GRO segment size from a control message buffer.
+// Missing values are returned as zero.
+func parseReceiveCmsgs(oob []byte) (timestamp int64, segmentSize int) {
+	for len(oob) >= syscall.CmsgLen(0) {
+		h := (*syscall.Cmsghdr)(unsafe.Pointer(&oob[0]))
+		if int(h.Len) < syscall.CmsgLen(0) || int(h.Len) > len(oob) {
+			break
+		}
+		data := oob[syscall.CmsgLen(0):h.Len]
+
+		switch {
+		case h.Level == syscall.SOL_SOCKET && h.Type == syscall.SCM_TIMESTAMPNS:
+			if len(data) >= int(unsafe.Sizeof(syscall.Timespec{})) {
+				ts := (*syscall.Timespec)(unsafe.Pointer(&data[0]))
+				timestamp = ts.Nano() / 1000
+			}
+		case h.Level == solUDP && h.Type == udpGRO:
+			if len(data) >= 4 {
+				segmentSize = int(*(*int32)(unsafe.Pointer(&data[0])))
+			}
+		}
+
+		next := syscall.CmsgSpace(int(h.Len) - syscall.CmsgLen(0))
+		if next >= len(oob) {
+			break
+		}
+		oob = oob[next:]
+	}
+	return
+}
+
+func sockaddrToUDPAddr(sa *syscall.RawSockaddrInet6) *net.UDPAddr {
+	port := (*[2]byte)(unsafe.Pointer(&sa.Port))
+	switch sa.Family {
+	case syscall.AF_INET:
+		sa4 := (*syscall.RawSockaddrInet4)(unsafe.Pointer(sa))
+		return &net.UDPAddr{
+			IP:   net.IPv4(sa4.Addr[0], sa4.Addr[1], sa4.Addr[2], sa4.Addr[3]).To4(),
+			Port: int(port[0])<<8 | int(port[1]),
+		}
+	case syscall.AF_INET6:
+		ip := make(net.IP, net.IPv6len)
+		copy(ip, sa.Addr[:])
+		return &net.UDPAddr{IP: ip, Port: int(port[0])<<8 | int(port[1])}
+	}
+	return nil
+}
@@ -0,0 +1,28 @@
+//go:build !linux
+// +build !linux
+
+package goquic
+
+import "net"
+
+// batchUDPReader reads one datagram per syscall on platforms without
+// recvmmsg. Receive timestamps are left zero, so packets are stamped when
+// they are processed.
+type batchUDPReader struct {
+	conn    *net.UDPConn
+	bufpool *BytesBufferPool
+}
+
+func newBatchUDPReader(conn *net.UDPConn, bufpool *BytesBufferPool) *batchUDPReader {
+	return &batchUDPReader{conn: conn, bufpool: bufpool}
+}
+
+func (r *batchUDPReader) ReadBatch(dst []UdpData) ([]UdpData, error) {
+	buf := r.bufpool.Get()
+	n, peer_addr, err := r.conn.ReadFromUDP(buf)
+	if err != nil {
+		r.bufpool.Put(buf)
+		return dst, err
+	}
+	return append(dst, UdpData{Addr: peer_addr, Buf: buf, N: n}), nil
+}
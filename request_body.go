@@ -0,0 +1,106 @@
+package goquic
+
+import (
+	"errors"
+	"io"
+	"sync"
+)
+
+var errBodyClosed = errors.New("goquic: read on closed request body")
+
+// requestBody is the req.Body of a streamed request. The event loop appends
+// data as the stream forwards it, and the handler reads it from its own
+// goroutine. Bytes are only reported consumed to the stream once the handler
+// has read them, so QUIC flow control stalls the peer while the handler is
+// slow. The stream never forwards more than a bounded amount of unconsumed
+// data, which bounds this buffer as well.
+type requestBody struct {
+	stream *SimpleServerStream
+
+	mu     sync.Mutex
+	cond   sync.Cond
+	chunks [][]byte
+	err    error // Set once the body is complete (io.EOF) or aborted
+	closed bool  // Closed by the handler
+}
+
+func newRequestBody(stream *SimpleServerStream) *requestBody {
+	b := &requestBody{stream: stream}
+	b.cond.L = &b.mu
+	return b
+}
+
+// write is called from the event loop and never blocks.
+func (b *requestBody) write(data []byte) {
+	if len(data) == 0 {
+		return
+	}
+	b.mu.Lock()
+	if !b.closed && b.err == nil {
+		b.chunks = append(b.chunks, data)
+		b.cond.Signal()
+	}
+	b.mu.Unlock()
+}
+
+// finish is called from the event loop when the body ends with |err|.
+func (b *requestBody) finish(err error) {
+	b.mu.Lock()
+	if b.err == nil {
+		b.err = err
+		b.cond.Signal()
+	}
+	b.mu.Unlock()
+}
+
+func (b *requestBody) Read(p []byte) (int, error) {
+	b.mu.Lock()
+	for len(b.chunks) == 0 && b.err == nil && !b.closed {
+		b.cond.Wait()
+	}
+	if b.closed {
+		b.mu.Unlock()
+		return 0, errBodyClosed
+	}
+	if len(b.chunks) == 0 {
+		err := b.err
+		b.mu.Unlock()
+		return 0, err
+	}
+
+	n := 0
+	for n < len(p) && len(b.chunks) > 0 {
+		c := copy(p[n:], b.chunks[0])
+		n += c
+		if c == len(b.chunks[0]) {
+			b.chunks[0] = nil
+			b.chunks = b.chunks[1:]
+		} else {
+			b.chunks[0] = b.chunks[0][c:]
+		}
+	}
+	b.mu.Unlock()
+
+	b.stream.markBodyConsumed(n)
+	return n, nil
+}
+
+// Close stops reading the body. If the handler has not read it to the end,
+// the rest is discarded.
+func (b *requestBody) Close() error {
+	b.mu.Lock()
+	if b.closed {
+		b.mu.Unlock()
+		return nil
+	}
+	b.closed = true
+	complete := b.err == io.EOF && len(b.chunks) == 0
+	b.chunks = nil
+	b.cond.Broadcast()
+	b.mu.Unlock()
+
+	if !complete {
+		b.stream.stopReadingBody()
+	}
+	return nil
+}
@@ -0,0 +1,70 @@
+package goquic
+
+// #include <stdlib.h>
+// #include "src/adaptor.h"
+import "C"
+import "unsafe"
+
+// Size of the C buffers response bodies are collected in
+const responseBufferSize = 32 * 1024
+
+// responseBodyWriter collects a response body in malloc'd buffers and hands
+// each full buffer over to the stream, which sends straight from it and frees
+// it once sent. Handler data is copied exactly once on its way to libquic.
+//
+// Not thread safe; used from the handler goroutine only.
+type responseBodyWriter struct {
+	stream *SimpleServerStream
+	buf    unsafe.Pointer // Owned by us until passed to writeBodyBuffer
+	n      int
+}
+
+func cBytes(p unsafe.Pointer, n int) []byte {
+	return (*[1 << 30]byte)(p)[:n:n]
+}
+
+func (w *responseBodyWriter) Write(p []byte) (int, error) {
+	written := len(p)
+	for len(p) > 0 {
+		if w.buf == nil {
+			if len(p) >= responseBufferSize {
+				// Large writes go out in a buffer of their own.
+				buf := C.malloc(C.size_t(len(p)))
+				copy(cBytes(buf, len(p)), p)
+				w.stream.writeBodyBuffer(buf, len(p))
+				break
+			}
+			w.buf = C.malloc(responseBufferSize)
+		}
+
+		c := copy(cBytes(w.buf, responseBufferSize)[w.n:], p)
+		w.n += c
+		p = p[c:]
+		if w.n == responseBufferSize {
+			w.Flush()
+		}
+	}
+	return written, nil
+}
+
+// Flush hands the partially filled buffer over to the stream.
+func (w *responseBodyWriter) Flush() error {
+	if w.buf == nil {
+		return nil
+	}
+	w.stream.writeBodyBuffer(w.buf, w.n)
+	w.buf = nil
+	w.n = 0
+	return nil
+}
+
+// writeBodyBuffer transfers ownership of |buf| to the stream.
+func (stream *SimpleServerStream) writeBodyBuffer(buf unsafe.Pointer, n int) {
+	stream.sessionFnChan <- func() {
+		if stream.closed {
+			C.free(buf)
+			return
+		}
+		stream.quicServerStream.WriteBodyBuffer(buf, n, false)
+	}
+}
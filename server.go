@@ -5,10 +5,13 @@ import (
 	"encoding/binary"
 	"errors"
 	"fmt"
+	"math"
 	"net"
 	"net/http"
 	"runtime"
+	"sync/atomic"
 	"time"
+	"unsafe"
 
 	"github.com/vanillahsu/go_reuseport"
 	"golang.org/x/net/http2"
@@ -24,10 +27,76 @@ type QuicSpdyServer struct {
 	Secret         string
 	ServerConfig   *SerializedServerConfig
 
+	// If set, each dispatcher reads only from its own SO_REUSEPORT socket and
+	// the kernel steers packets to the right socket by connection ID, so
+	// packets are not parsed in Go and never go through another dispatcher's
+	// reader. They are still handed from the socket's reader goroutine to
+	// the dispatcher over a channel. Linux only.
+	KernelSharding bool
+
+	// If non-zero, embedded in the top 16 bits of server-chosen connection IDs
+	// so that an L4 load balancer can route packets back to this host.
+	ServerId uint16
+
+	// If set, handlers are started as soon as the request headers arrive and
+	// read the request body while it is still being received. Otherwise the
+	// whole body is buffered before the handler runs.
+	StreamRequestBody bool
+
+	// Number of goroutines signing handshake proofs, so that a CHLO does not
+	// stall every other connection of its dispatcher. Defaults to the number
+	// of CPUs; negative signs on the dispatcher threads.
+	ProofWorkers int
+
+	// If set, proofs are signed with BoringSSL in C++ using the certificate's
+	// private key, rather than with Go's crypto packages.
+	NativeProofSigning bool
+
+	// Number of sessions per dispatcher whose connection stats are sampled
+	// by Statistics(). Zero only reports the aggregated counters.
+	SessionStatisticsSample int
+
+	// Maximum number of recently closed connection IDs each dispatcher keeps
+	// in time-wait state. Zero uses the libquic default (600000); negative
+	// means unlimited.
+	TimeWaitListMaxConnections int
+
+	// If positive, each dispatcher creates at most this many sessions per
+	// loop iteration. Further CHLOs are buffered and handled by later
+	// iterations, so established sessions keep being serviced during a
+	// connection storm. At most 32767.
+	NewSessionsPerLoop int
+
+	// Admission control of new connections per dispatcher; zero disables
+	// each check. CHLOs are turned away while MaxSessionsPerDispatcher
+	// sessions are open, while the smoothed event loop lag exceeds
+	// ShedLoopLag, or beyond ChloRatePerPrefix per second (with bursts of
+	// ChloBurstPerPrefix) from one /24 IPv4 or /48 IPv6 prefix.
+	MaxSessionsPerDispatcher int
+	ShedLoopLag              time.Duration
+	ChloRatePerPrefix        float64
+	ChloBurstPerPrefix       float64
+
+	// If positive, each dispatcher drops packets which do not belong to an
+	// open session beyond this many per second (with bursts of
+	// UnknownPacketBurstPerSource) from one IPv4 address or IPv6 /56,
+	// before parsing them. Keeps a flood of garbage or version negotiation
+	// triggers from a single source off the dispatcher's core.
+	UnknownPacketRatePerSource  float64
+	UnknownPacketBurstPerSource float64
+
 	numOfServers  int
 	isSecure      bool
 	statisticsReq [](chan statCallback)
 	bufpool       *BytesBufferPool
+
+	// C++ counters of each dispatcher, published once it is created.
+	dispatcherMetrics []unsafe.Pointer
+
+	// Shared by every dispatcher. Kept for the lifetime of the process, as
+	// the dispatcher loops never return.
+	cryptoConfig *QuicCryptoServerConfig
+	proofSource  *ProofSource
 }
 
 func (srv *QuicSpdyServer) Statistics() (*ServerStatistics, error) {
@@ -35,7 +104,10 @@ func (srv *QuicSpdyServer) Statistics() (*ServerStatistics, error) {
 		return nil, errors.New("Server not started")
 	}
 
-	serverStat := &ServerStatistics{}
+	serverStat := &ServerStatistics{Dispatchers: srv.Metrics()}
+	if srv.proofSource != nil {
+		serverStat.SignatureCacheHits, serverStat.SignatureCacheMisses = srv.proofSource.SignatureCacheStats()
+	}
 	dispatcherStatCh := make(chan DispatcherStatistics)
 
 	go func() {
@@ -50,6 +122,7 @@ func (srv *QuicSpdyServer) Statistics() (*ServerStatistics, error) {
 
 	for dispatcherStat := range dispatcherStatCh {
 		serverStat.SessionStatistics = append(serverStat.SessionStatistics, dispatcherStat.SessionStatistics...)
+		serverStat.PoolStatistics = append(serverStat.PoolStatistics, dispatcherStat.PoolStatistics)
 	}
 
 	return serverStat, nil
@@ -65,6 +138,7 @@ func (srv *QuicSpdyServer) ListenAndServe() error {
 	writerArray := make([](*ServerWriter), srv.numOfServers)
 	connArray := make([](*net.UDPConn), srv.numOfServers)
 	srv.statisticsReq = make([](chan statCallback), srv.numOfServers)
+	srv.dispatcherMetrics = make([]unsafe.Pointer, srv.numOfServers)
 	srv.bufpool = NewBytesBufferPool(1000, 3000) // 3000 = MTU (kMaxPacketSize) * 2
 
 	if srv.ServerConfig == nil {
@@ -75,10 +149,31 @@ func (srv *QuicSpdyServer) ListenAndServe() error {
 		srv.Secret = "secret"
 	}
 
+	proofSource := NewProofSource(srv.Certificate)
+	if srv.NativeProofSigning {
+		if err := proofSource.UseNativeSigning(); err != nil {
+			return err
+		}
+	}
+	if srv.ProofWorkers == 0 {
+		srv.ProofWorkers = runtime.NumCPU()
+	}
+	if srv.ProofWorkers > 0 {
+		proofSource.StartWorkers(srv.ProofWorkers)
+	}
+	if srv.NewSessionsPerLoop > math.MaxInt16 {
+		srv.NewSessionsPerLoop = math.MaxInt16
+	}
+	if srv.NewSessionsPerLoop > 0 {
+		EnableBufferPacketsTillChlo()
+	}
+	srv.cryptoConfig = NewCryptoServerConfig(proofSource, srv.Secret, srv.ServerConfig)
+	srv.proofSource = proofSource
+
 	// N consumers
 	for i := 0; i < srv.numOfServers; i++ {
 		rch := make(chan UdpData, 500)
-		wch := make(chan UdpData, 500) // TODO(serialx, hodduc): Optimize buffer size
+		wch := make(chan []UdpData, 500) // TODO(serialx, hodduc): Optimize buffer size
 		statch := make(chan statCallback, 0)
 
 		conn, err := reuseport.NewReusablePortPacketConn("udp4", addr)
@@ -103,28 +198,51 @@ func (srv *QuicSpdyServer) ListenAndServe() error {
 		readChanArray[i] = rch
 		writerArray[i] = NewServerWriter(wch)
 		srv.statisticsReq[i] = statch
-		go srv.Serve(listen_addr, writerArray[i], readChanArray[i], srv.statisticsReq[i])
+		go srv.Serve(listen_addr, i, writerArray[i], readChanArray[i], srv.statisticsReq[i])
+	}
+
+	if srv.KernelSharding {
+		// The program is shared by the whole reuseport group, so attach it once
+		// all sockets are bound.
+		if err := attachShardingProgram(connArray[0], srv.numOfServers); err != nil {
+			return err
+		}
 	}
 
 	// N producers
-	readFunc := func(conn *net.UDPConn) {
+	readErrChan := make(chan error, srv.numOfServers)
+	readFunc := func(conn *net.UDPConn, shard int) {
+		reader := newBatchUDPReader(conn, srv.bufpool)
+		packets := make([]UdpData, 0, maxPacketBatchSize)
 		for {
-			buf := srv.bufpool.Get()
-
-			n, peer_addr, err := conn.ReadFromUDP(buf)
+			var err error
+			packets, err = reader.ReadBatch(packets[:0])
 			if err != nil {
-				// TODO(serialx): Don't panic and keep calm...
-				panic(err)
-			}
-			// Ignore zero length packet
-			if n == 0 {
-				continue
+				if ne, ok := err.(net.Error); ok && ne.Temporary() {
+					continue
+				}
+				readErrChan <- err
+				return
 			}
 
-			var connId uint64 = 0
-			var parsed bool = false
+			for _, dat := range packets {
+				buf := dat.Buf
+				n := dat.N
+				// Ignore zero length packet
+				if n == 0 {
+					srv.bufpool.Put(buf)
+					continue
+				}
+
+				if srv.KernelSharding {
+					// Already steered to the right socket by the kernel.
+					readChanArray[shard] <- dat
+					continue
+				}
+
+				var connId uint64 = 0
+				var parsed bool = false
 
-			if len(buf) > 0 {
 				switch buf[0] & 0x8 {
 				case 0x8:
 					// 8-byte connection id
@@ -137,41 +255,49 @@ func (srv *QuicSpdyServer) ListenAndServe() error {
 					connId = 0
 					parsed = true
 				}
-			}
 
-			if !parsed {
-				// Ignore strange packet
-				continue
-			}
+				if !parsed {
+					// Ignore strange packet
+					srv.bufpool.Put(buf)
+					continue
+				}
 
-			readChanArray[connId%uint64(srv.numOfServers)] <- UdpData{Addr: peer_addr, Buf: buf, N: n}
-			// TODO(hodduc): Minimize heap uses of buf. Consider using sync.Pool standard library to implement buffer pool.
+				readChanArray[connectionShard(connId, srv.numOfServers)] <- dat
+			}
 		}
 	}
 
 	// N consumers
 	writeFunc := func(conn *net.UDPConn, writer *ServerWriter) {
-		for dat := range writer.Ch {
-			conn.WriteToUDP(dat.Buf, dat.Addr)
+		batchWriter := newBatchUDPWriter(conn)
+		for batch := range writer.Ch {
+			batchWriter.WriteBatch(batch)
+			writer.Drained()
 		}
 	}
 
-	for i := 0; i < srv.numOfServers-1; i++ {
+	for i := 0; i < srv.numOfServers; i++ {
 		go writeFunc(connArray[i], writerArray[i])
-		go readFunc(connArray[i])
+		go readFunc(connArray[i], i)
 	}
 
-	go writeFunc(connArray[srv.numOfServers-1], writerArray[srv.numOfServers-1])
-	readFunc(connArray[srv.numOfServers-1])
-	return nil
+	return <-readErrChan
+}
+
+// connectionShard returns the dispatcher owning |connId|. Only the low 32 bits
+// are used so that the result matches the kernel steering program.
+func connectionShard(connId uint64, numOfServers int) int {
+	return int(uint32(connId) % uint32(numOfServers))
 }
 
-func (srv *QuicSpdyServer) Serve(listen_addr *net.UDPAddr, writer *ServerWriter, readChan chan UdpData, statChan chan statCallback) error {
+func (srv *QuicSpdyServer) Serve(listen_addr *net.UDPAddr, shard int, writer *ServerWriter, readChan chan UdpData, statChan chan statCallback) error {
 	runtime.LockOSThread()
 
-	proofSource := NewProofSource(srv.Certificate)
-	cryptoConfig := NewCryptoServerConfig(proofSource, srv.Secret, srv.ServerConfig)
-	defer DeleteCryptoServerConfig(cryptoConfig)
+	cryptoConfig := srv.cryptoConfig
+	if cryptoConfig == nil {
+		cryptoConfig = NewCryptoServerConfig(NewProofSource(srv.Certificate), srv.Secret, srv.ServerConfig)
+		defer DeleteCryptoServerConfig(cryptoConfig)
+	}
 
 	sessionFnChan := make(chan func())
 
@@ -179,7 +305,44 @@ func (srv *QuicSpdyServer) Serve(listen_addr *net.UDPAddr, writer *ServerWriter,
 		return &SpdyServerSession{server: srv, sessionFnChan: sessionFnChan}
 	}
 
-	dispatcher := CreateQuicDispatcher(writer, createSpdySession, CreateTaskRunner(), cryptoConfig)
+	dispatcherConfig := DispatcherConfig{
+		ShardIndex:                 shard,
+		NumShards:                  srv.numOfServers,
+		ServerId:                   srv.ServerId,
+		TimeWaitListMaxConnections: srv.TimeWaitListMaxConnections,
+		LimitNewSessionsPerLoop:    srv.NewSessionsPerLoop > 0,
+		MaxSessions:                srv.MaxSessionsPerDispatcher,
+		MaxLoopLag:                 srv.ShedLoopLag,
+		ChloRatePerPrefix:          srv.ChloRatePerPrefix,
+		ChloBurstPerPrefix:         srv.ChloBurstPerPrefix,
+
+		UnknownPacketRatePerSource:  srv.UnknownPacketRatePerSource,
+		UnknownPacketBurstPerSource: srv.UnknownPacketBurstPerSource,
+	}
+	dispatcher := CreateQuicDispatcher(writer, createSpdySession, CreateTaskRunner(), cryptoConfig, dispatcherConfig)
+	if shard < len(srv.dispatcherMetrics) {
+		atomic.StorePointer(&srv.dispatcherMetrics[shard], dispatcher.metrics())
+	}
+	batch := NewPacketBatch()
+
+	// While CHLOs are buffered, pendingChlos is set to an always ready
+	// channel so that the loop comes back to them without blocking, between
+	// servicing everything else.
+	chlosReady := make(chan struct{})
+	close(chlosReady)
+	var pendingChlos <-chan struct{}
+	startIteration := func() {
+		if srv.NewSessionsPerLoop > 0 && dispatcher.ProcessBufferedChlos(srv.NewSessionsPerLoop) {
+			pendingChlos = chlosReady
+		} else {
+			pendingChlos = nil
+		}
+	}
+	updatePendingChlos := func() {
+		if srv.NewSessionsPerLoop > 0 && dispatcher.HasChlosBuffered() {
+			pendingChlos = chlosReady
+		}
+	}
 
 	for {
 		select {
@@ -187,21 +350,58 @@ func (srv *QuicSpdyServer) Serve(listen_addr *net.UDPAddr, writer *ServerWriter,
 			if !ok {
 				break
 			}
-			dispatcher.ProcessPacket(listen_addr, result.Addr, result.Buf[:result.N])
-			srv.bufpool.Put(result.Buf)
+			startIteration()
+			if result.Timestamp > 0 {
+				dispatcher.OnLoopLag(time.Duration(time.Now().UnixNano()/1000-result.Timestamp) * time.Microsecond)
+			}
 
-		case <-dispatcher.TaskRunner.WaitTimer():
+			// Drain whatever else is already queued so that a burst of
+			// datagrams costs a single trip into C++.
+			batch.Add(result.Addr, result.Buf[:result.N], result.Timestamp)
+			srv.bufpool.Put(result.Buf)
+		drain:
+			for batch.Len() < maxPacketBatchSize {
+				select {
+				case result, ok := <-readChan:
+					if !ok {
+						break drain
+					}
+					if !batch.Add(result.Addr, result.Buf[:result.N], result.Timestamp) {
+						dispatcher.ProcessPackets(listen_addr, batch)
+						batch.Add(result.Addr, result.Buf[:result.N], result.Timestamp)
+					}
+					srv.bufpool.Put(result.Buf)
+				default:
+					break drain
+				}
+			}
+			dispatcher.ProcessPackets(listen_addr, batch)
+			updatePendingChlos()
+
+		case <-pendingChlos:
+			startIteration()
+			dispatcher.FlushWrites()
+		case firedAt := <-dispatcher.TaskRunner.WaitTimer():
+			dispatcher.OnLoopLag(time.Since(firedAt))
 			dispatcher.TaskRunner.DoTasks()
+			dispatcher.FlushWrites()
 		case fn, ok := <-sessionFnChan:
 			if !ok {
 				break
 			}
 			fn()
+			dispatcher.FlushWrites()
+		case fn := <-dispatcher.proofDone:
+			fn()
+			dispatcher.FlushWrites()
+		case <-writer.Writable:
+			dispatcher.OnWriterUnblocked()
+			dispatcher.FlushWrites()
 		case statCallback, ok := <-statChan:
 			if !ok {
 				break
 			}
-			stat := dispatcher.Statistics()
+			stat := dispatcher.Statistics(srv.SessionStatisticsSample)
 			statCallback <- stat
 		}
 	}
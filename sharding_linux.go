@@ -0,0 +1,96 @@
+package goquic
+
+/*
+#include <linux/filter.h>
+#include <sys/socket.h>
+
+#ifndef SO_ATTACH_REUSEPORT_CBPF
+#define SO_ATTACH_REUSEPORT_CBPF 51
+#endif
+
+static int goquic_attach_reuseport_cbpf(int fd, struct sock_filter* filter, unsigned short len) {
+	struct sock_fprog prog;
+	prog.len = len;
+	prog.filter = filter;
+	return setsockopt(fd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog));
+}
+*/
+import "C"
+import (
+	"net"
+	"syscall"
+)
+
+func bpfStmt(code uint16, k uint32) C.struct_sock_filter {
+	return C.struct_sock_filter{code: C.__u16(code), k: C.__u32(k)}
+}
+
+func bpfJump(code uint16, k uint32, jt, jf uint8) C.struct_sock_filter {
+	return C.struct_sock_filter{code: C.__u16(code), jt: C.__u8(jt), jf: C.__u8(jf), k: C.__u32(k)}
+}
+
+// attachShardingProgram installs a classic BPF program on the reuseport group
+// of |conn| that picks the socket by connection ID, the same way
+// connectionShard does. Packets without a connection ID are left to the
+// kernel's default reuseport hash.
+//
+// The program relies on socket i of the group being the i-th socket bound to
+// the port, so every socket of the group must be created before packets
+// arrive.
+func attachShardingProgram(conn *net.UDPConn, numShards int) error {
+	const (
+		ldB     = syscall.BPF_LD | syscall.BPF_B | syscall.BPF_ABS
+		ldLen   = syscall.BPF_LD | syscall.BPF_W | syscall.BPF_LEN
+		jge     = syscall.BPF_JMP | syscall.BPF_JGE | syscall.BPF_K
+		jset    = syscall.BPF_JMP | syscall.BPF_JSET | syscall.BPF_K
+		lsh     = syscall.BPF_ALU | syscall.BPF_LSH | syscall.BPF_K
+		orX     = syscall.BPF_ALU | syscall.BPF_OR | syscall.BPF_X
+		modK    = syscall.BPF_ALU | C.BPF_MOD | syscall.BPF_K
+		tax     = syscall.BPF_MISC | syscall.BPF_TAX
+		retA    = syscall.BPF_RET | syscall.BPF_A
+		retK    = syscall.BPF_RET | syscall.BPF_K
+		noShard = 0xffffffff // Out of range index: fall back to hashing
+	)
+
+	// The data offset is the start of the UDP payload. The connection ID is
+	// stored little-endian at bytes 1..8 when bit 0x08 of the public flags is
+	// set; only its low 32 bits are used.
+	filter := []C.struct_sock_filter{
+		bpfStmt(ldLen, 0),
+		bpfJump(jge, 9, 0, 17), // Too short for a connection ID
+		bpfStmt(ldB, 0),
+		bpfJump(jset, 0x08, 0, 15), // Connection ID omitted
+		bpfStmt(ldB, 4),
+		bpfStmt(lsh, 8),
+		bpfStmt(tax, 0),
+		bpfStmt(ldB, 3),
+		bpfStmt(orX, 0),
+		bpfStmt(lsh, 8),
+		bpfStmt(tax, 0),
+		bpfStmt(ldB, 2),
+		bpfStmt(orX, 0),
+		bpfStmt(lsh, 8),
+		bpfStmt(tax, 0),
+		bpfStmt(ldB, 1),
+		bpfStmt(orX, 0),
+		bpfStmt(modK, uint32(numShards)),
+		bpfStmt(retA, 0),
+		bpfStmt(retK, noShard),
+	}
+
+	raw, err := conn.SyscallConn()
+	if err != nil {
+		return err
+	}
+
+	var attachErr error
+	err = raw.Control(func(fd uintptr) {
+		if rc, errno := C.goquic_attach_reuseport_cbpf(C.int(fd), &filter[0], C.ushort(len(filter))); rc != 0 {
+			attachErr = errno
+		}
+	})
+	if err != nil {
+		return err
+	}
+	return attachErr
+}
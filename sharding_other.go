@@ -0,0 +1,13 @@
+//go:build !linux
+// +build !linux
+
+package goquic
+
+import (
+	"errors"
+	"net"
+)
+
+func attachShardingProgram(conn *net.UDPConn, numShards int) error {
+	return errors.New("kernel sharding is only supported on Linux")
+}
@@ -4,7 +4,6 @@
 #include "go_quic_connection_helper.h"
 #include "go_quic_server_packet_writer.h"
 #include "go_quic_simple_server_stream.h"
-#include "go_quic_alarm_go_wrapper.h"
 #include "go_quic_alarm_factory.h"
 #include "go_quic_simple_server_session_helper.h"
 #include "go_utils.h"
@@ -12,6 +11,7 @@
 #include "go_ephemeral_key_source.h"
 
 #include "net/quic/core/quic_connection.h"
+#include "net/quic/core/quic_flags.h"
 #include "net/quic/core/quic_clock.h"
 #include "net/quic/core/quic_time.h"
 #include "net/quic/core/quic_protocol.h"
@@ -28,6 +28,7 @@
 #include <iostream>
 #include <vector>
 #include <stddef.h>
+#include <string.h>
 
 #define EXPECT_TRUE(x) \
   {                    \
@@ -38,6 +39,10 @@
 using namespace net;
 using namespace std;
 
+// Buckets of the per-source limiter of packets for unknown connections, about
+// 100KB per dispatcher.
+static const size_t kUnknownPacketRateLimiterBuckets = 4096;
+
 static base::AtExitManager* exit_manager;
 void initialize() {
   int argc = 1;
@@ -131,7 +136,9 @@ static QuicServerConfigProtobuf* parse_goquic_crypto_config(GoQuicServerConfig*
   return config;
 }
 
-// Takes ownership of proof_source
+// Takes ownership of proof_source. The returned config may be shared by any
+// number of dispatchers: QuicCryptoServerConfig locks its config list
+// internally, and ProofSourceGoquic and GoEphemeralKeySource are thread-safe.
 QuicCryptoServerConfig* init_crypto_config(
     GoQuicServerConfig* go_config,
     ProofSourceGoquic* proof_source,
@@ -167,7 +174,9 @@ GoQuicSimpleDispatcher* create_quic_dispatcher(
     GoPtr go_writer,
     GoPtr go_quic_dispatcher,
     GoPtr go_task_runner,
-    QuicCryptoServerConfig* crypto_config) {
+    GoQuicTimerWheel* timer_wheel,
+    QuicCryptoServerConfig* crypto_config,
+    struct GoQuicDispatcherConfig* dispatcher_config) {
   QuicConfig* config = new QuicConfig();
   // Deleted by ~GoQuicDispatcher()
   QuicClock* clock =
@@ -175,8 +184,8 @@ GoQuicSimpleDispatcher* create_quic_dispatcher(
   QuicRandom* random_generator = QuicRandom::GetInstance();
 
   std::unique_ptr<QuicConnectionHelperInterface> helper(new GoQuicConnectionHelper(clock, random_generator));
-  std::unique_ptr<QuicAlarmFactory> alarm_factory(new GoQuicAlarmFactory(clock, go_task_runner));
-  std::unique_ptr<QuicCryptoServerStream::Helper> session_helper(new GoQuicSimpleServerSessionHelper(QuicRandom::GetInstance()));
+  std::unique_ptr<QuicAlarmFactory> alarm_factory(new GoQuicAlarmFactory(timer_wheel, go_task_runner));
+  std::unique_ptr<QuicCryptoServerStream::Helper> session_helper(new GoQuicSimpleServerSessionHelper(QuicRandom::GetInstance(), *dispatcher_config));
   // XXX: quic_server uses QuicSimpleCryptoServerStreamHelper, 
   // while quic_simple_server uses QuicSimpleServerSessionHelper.
   // Pick one and remove the other later
@@ -207,14 +216,38 @@ GoQuicSimpleDispatcher* create_quic_dispatcher(
           std::move(helper), std::move(session_helper), std::move(alarm_factory), go_quic_dispatcher);
 
   GoQuicServerPacketWriter* writer = new GoQuicServerPacketWriter(
-      go_writer, dispatcher);  // Deleted by scoped ptr of GoQuicDispatcher
+      go_writer, dispatcher,
+      dispatcher->metrics());  // Deleted by scoped ptr of GoQuicDispatcher
 
   dispatcher->InitializeWithWriter(writer);
+  if (dispatcher_config->Time_wait_max_connections != 0) {
+    dispatcher->SetTimeWaitListMaxConnections(
+        dispatcher_config->Time_wait_max_connections);
+  }
+  dispatcher->set_limit_new_sessions_per_event_loop(
+      dispatcher_config->Limit_new_sessions_per_loop != 0);
+  dispatcher->set_admission_policy(GoQuicAdmissionController::Create(
+      *dispatcher_config, random_generator->RandUint64()));
+  if (dispatcher_config->Unknown_packet_rate_per_source > 0) {
+    double burst = dispatcher_config->Unknown_packet_burst_per_source > 0
+                       ? dispatcher_config->Unknown_packet_burst_per_source
+                       : dispatcher_config->Unknown_packet_rate_per_source;
+    dispatcher->set_unknown_packet_rate_limiter(
+        std::unique_ptr<GoQuicPrefixRateLimiter>(new GoQuicPrefixRateLimiter(
+            32, 56, dispatcher_config->Unknown_packet_rate_per_source, burst,
+            kUnknownPacketRateLimiterBuckets, random_generator->RandUint64())));
+  }
+  // The wheel is released together with the dispatcher's alarm factory.
+  timer_wheel->set_metrics(dispatcher->metrics());
+
+  // The dispatcher is only ever driven from this (locked) thread.
+  ProofSourceGoquic::SetThreadDispatcher(go_quic_dispatcher);
 
   return dispatcher;
 }
 
 void delete_go_quic_dispatcher(GoQuicSimpleDispatcher* dispatcher) {
+  ProofSourceGoquic::SetThreadDispatcher(0);
   delete dispatcher;
 }
 
@@ -237,6 +270,100 @@ void quic_dispatcher_process_packet(GoQuicSimpleDispatcher* dispatcher,
       false /* Do not own the buffer, so will not free buffer in the destructor */);
 
   dispatcher->ProcessPacket(self_address, peer_address, packet);
+  dispatcher->FlushWrites();
+}
+
+// Converts a receive timestamp in UNIX microseconds into the QuicTime domain,
+// given the same instant as |now| and |wall_now|. Timestamps that are missing
+// or ahead of the wall clock map to |now|.
+static QuicTime ToQuicReceiveTime(QuicTime now,
+                                  QuicWallTime wall_now,
+                                  int64_t timestamp_us) {
+  if (timestamp_us <= 0) {
+    return now;
+  }
+  QuicWallTime received = QuicWallTime::FromUNIXMicroseconds(timestamp_us);
+  if (wall_now.IsBefore(received)) {
+    return now;
+  }
+  return now - wall_now.AbsoluteDifference(received);
+}
+
+void quic_dispatcher_process_packets(GoQuicSimpleDispatcher* dispatcher,
+                                     uint8_t* self_address_ip,
+                                     size_t self_address_len,
+                                     uint16_t self_address_port,
+                                     struct GoPacketDesc* packets,
+                                     size_t num_packets,
+                                     char* buffer) {
+  IPAddress self_ip_addr(self_address_ip, self_address_len);
+  IPEndPoint self_address(self_ip_addr, self_address_port);
+
+  const QuicClock* clock = dispatcher->helper()->GetClock();
+  QuicTime now = clock->Now();
+  QuicWallTime wall_now = clock->WallNow();
+
+  IPEndPoint peer_address;
+  for (size_t i = 0; i < num_packets; i++) {
+    const GoPacketDesc& desc = packets[i];
+
+    // Consecutive datagrams mostly come from the same peer, so only rebuild
+    // the endpoint when it changes.
+    if (i == 0 || desc.Peer_port != packets[i - 1].Peer_port ||
+        desc.Peer_ip_len != packets[i - 1].Peer_ip_len ||
+        memcmp(desc.Peer_ip, packets[i - 1].Peer_ip, desc.Peer_ip_len) != 0) {
+      IPAddress peer_ip_addr(desc.Peer_ip, desc.Peer_ip_len);
+      peer_address = IPEndPoint(peer_ip_addr, desc.Peer_port);
+    }
+
+    QuicReceivedPacket packet(
+        buffer + desc.Offset, desc.Length,
+        ToQuicReceiveTime(now, wall_now, desc.Timestamp),
+        false /* Do not own the buffer, so will not free buffer in the destructor */);
+
+    dispatcher->ProcessPacket(self_address, peer_address, packet);
+  }
+  dispatcher->FlushWrites();
+}
+
+void quic_dispatcher_flush_writes(GoQuicSimpleDispatcher* dispatcher) {
+  dispatcher->FlushWrites();
+}
+
+void quic_dispatcher_on_writer_unblocked(GoQuicSimpleDispatcher* dispatcher) {
+  dispatcher->OnWriterUnblocked();
+}
+
+void quic_dispatcher_pool_stats(GoQuicSimpleDispatcher* dispatcher,
+                                struct GoQuicPoolStats* stats) {
+  // The pools belong to the thread, which only ever runs |dispatcher|.
+  GoQuicSimpleDispatcher::GetPoolStats(stats);
+}
+
+// Starts a new event loop iteration with a budget of |max_new_sessions|,
+// spent first on buffered CHLOs. Returns whether any are still buffered.
+int quic_dispatcher_process_buffered_chlos(GoQuicSimpleDispatcher* dispatcher,
+                                           size_t max_new_sessions) {
+  dispatcher->ProcessBufferedChlos(max_new_sessions);
+  return dispatcher->HasChlosBuffered();
+}
+
+int quic_dispatcher_has_chlos_buffered(GoQuicSimpleDispatcher* dispatcher) {
+  return dispatcher->HasChlosBuffered();
+}
+
+void quic_dispatcher_on_loop_lag(GoQuicSimpleDispatcher* dispatcher,
+                                 int64_t lag_us) {
+  dispatcher->OnLoopLag(QuicTime::Delta::FromMicroseconds(lag_us));
+}
+
+GoQuicDispatcherMetrics* quic_dispatcher_metrics(GoQuicSimpleDispatcher* dispatcher) {
+  return dispatcher->metrics();
+}
+
+void quic_dispatcher_metrics_snapshot(GoQuicDispatcherMetrics* metrics,
+                                      struct GoQuicDispatcherStats* stats) {
+  metrics->Snapshot(stats);
 }
 
 SpdyHeaderBlock* initialize_header_block() {
@@ -273,7 +400,36 @@ void quic_simple_server_stream_write_or_buffer_data(
     char* buf,
     size_t bufsize,
     int fin) {
-  wrapper->WriteOrBufferBody(std::string(buf, bufsize), (fin != 0), nullptr);
+  wrapper->WriteOrBufferBodyInOrder(base::StringPiece(buf, bufsize), (fin != 0));
+}
+
+void quic_simple_server_stream_write_body_buffer(
+    GoQuicSimpleServerStream* wrapper,
+    char* buf,
+    size_t bufsize,
+    int fin) {
+  wrapper->WriteBodyBuffer(buf, bufsize, (fin != 0));
+}
+
+void quic_simple_server_stream_enable_body_streaming(
+    GoQuicSimpleServerStream* wrapper) {
+  wrapper->EnableBodyStreaming();
+}
+
+void quic_simple_server_stream_mark_body_consumed(
+    GoQuicSimpleServerStream* wrapper,
+    size_t num_bytes) {
+  wrapper->MarkBodyConsumed(num_bytes);
+}
+
+void quic_simple_server_stream_stop_reading_body(
+    GoQuicSimpleServerStream* wrapper) {
+  wrapper->StopReadingBody();
+}
+
+int quic_simple_server_stream_write_side_closed(
+    GoQuicSimpleServerStream* wrapper) {
+  return wrapper->write_side_closed();
 }
 
 void quic_simple_server_stream_write_trailers(GoQuicSimpleServerStream* wrapper,
@@ -287,12 +443,20 @@ void quic_simple_server_stream_write_trailers(GoQuicSimpleServerStream* wrapper,
   wrapper->WriteTrailers(std::move(block), nullptr);
 }
 
-void go_quic_alarm_fire(GoQuicAlarmGoWrapper* go_quic_alarm) {
-  go_quic_alarm->Fire_();
+GoQuicTimerWheel* create_go_quic_timer_wheel() {
+  return new GoQuicTimerWheel();  // Deleted by delete_go_quic_timer_wheel()
+}
+
+void delete_go_quic_timer_wheel(GoQuicTimerWheel* timer_wheel) {
+  delete timer_wheel;
+}
+
+struct GoQuicTimerWheelState* go_quic_timer_wheel_state(GoQuicTimerWheel* timer_wheel) {
+  return timer_wheel->state();
 }
 
-int64_t clock_now(QuicClock* quic_clock) {
-  return (quic_clock->Now() - QuicTime::Zero()).ToMicroseconds();
+void go_quic_timer_wheel_fire_expired(GoQuicTimerWheel* timer_wheel) {
+  timer_wheel->FireExpired();
 }
 
 void packet_writer_on_write_complete(GoQuicServerPacketWriter* cb, int rv) {
@@ -357,3 +521,46 @@ void proof_source_goquic_add_cert(ProofSourceGoquic* proof_source, char* cert_c,
 void proof_source_goquic_build_cert_chain(ProofSourceGoquic* proof_source) {
   proof_source->BuildCertChain();
 }
+
+int proof_source_goquic_set_private_key(ProofSourceGoquic* proof_source,
+                                        char* der,
+                                        size_t der_sz) {
+  return proof_source->SetPrivateKey(der, der_sz) ? 1 : 0;
+}
+
+void proof_source_goquic_start_signing_threads(ProofSourceGoquic* proof_source,
+                                              int num_threads) {
+  proof_source->StartSigningThreads(num_threads);
+}
+
+void proof_source_goquic_get_signature_cache_stats(
+    ProofSourceGoquic* proof_source,
+    uint64_t* hits,
+    uint64_t* misses) {
+  proof_source->GetSignatureCacheStats(hits, misses);
+}
+
+void proof_source_goquic_complete_get_proof(GoQuicGetProofJob* job,
+                                            int ok,
+                                            char* signature,
+                                            size_t signature_sz) {
+  ProofSourceGoquic::CompleteGetProof(job, (ok != 0), signature, signature_sz);
+}
+
+void proof_source_goquic_complete_signed_proof(GoQuicGetProofJob* job) {
+  ProofSourceGoquic::CompleteSignedProof(job);
+}
+
+// Makes the crypto config use the callback based ProofSource::GetProof(),
+// which ProofSourceGoquic hands to its signing threads or Go's workers.
+void set_async_get_proof(int enabled) {
+  FLAGS_enable_async_get_proof = (enabled != 0);
+}
+
+// Makes every dispatcher buffer packets of unknown connections until their
+// CHLO arrives, which the per-dispatcher session limit relies on. Dispatchers
+// without a limit still create the session as soon as the CHLO arrives, so
+// this is never turned off again.
+void enable_buffer_packets_till_chlo() {
+  FLAGS_quic_buffer_packet_till_chlo = true;
+}
@@ -8,7 +8,7 @@
 #ifdef __cplusplus
 #include "go_quic_simple_dispatcher.h"
 #include "go_quic_simple_server_stream.h"
-#include "go_quic_alarm_go_wrapper.h"
+#include "go_quic_timer_wheel.h"
 #include "go_quic_server_packet_writer.h"
 #include "proof_source_goquic.h"
 #include "net/quic/core/quic_connection.h"
@@ -24,12 +24,13 @@ typedef void QuicConnection;
 typedef void GoQuicSimpleDispatcher;
 typedef void GoQuicSimpleServerStream;
 typedef void SpdyHeaderBlock;
-typedef void GoQuicAlarmGoWrapper;
-typedef void QuicClock;
+typedef void GoQuicTimerWheel;
 typedef void GoQuicServerPacketWriter;
 typedef void QuicCryptoServerConfig;
 typedef void ProofSourceGoquic;
+typedef void GoQuicGetProofJob;
 typedef void QuicServerSessionBase;
+typedef void GoQuicDispatcherMetrics;
 #endif
 
 void initialize();
@@ -51,7 +52,9 @@ void delete_crypto_config(QuicCryptoServerConfig* config);
 GoQuicSimpleDispatcher* create_quic_dispatcher(GoPtr go_writer_,
                                          GoPtr go_quic_dispatcher,
                                          GoPtr go_task_runner,
-                                         QuicCryptoServerConfig* crypto_config);
+                                         GoQuicTimerWheel* timer_wheel,
+                                         QuicCryptoServerConfig* crypto_config,
+                                         struct GoQuicDispatcherConfig* dispatcher_config);
 void delete_go_quic_dispatcher(GoQuicSimpleDispatcher* dispatcher);
 void quic_dispatcher_process_packet(GoQuicSimpleDispatcher* dispatcher,
                                     uint8_t* self_address_ip,
@@ -62,6 +65,25 @@ void quic_dispatcher_process_packet(GoQuicSimpleDispatcher* dispatcher,
                                     uint16_t peer_address_port,
                                     char* buffer,
                                     size_t length);
+void quic_dispatcher_process_packets(GoQuicSimpleDispatcher* dispatcher,
+                                     uint8_t* self_address_ip,
+                                     size_t self_address_len,
+                                     uint16_t self_address_port,
+                                     struct GoPacketDesc* packets,
+                                     size_t num_packets,
+                                     char* buffer);
+void quic_dispatcher_flush_writes(GoQuicSimpleDispatcher* dispatcher);
+void quic_dispatcher_on_writer_unblocked(GoQuicSimpleDispatcher* dispatcher);
+void quic_dispatcher_pool_stats(GoQuicSimpleDispatcher* dispatcher,
+                                struct GoQuicPoolStats* stats);
+int quic_dispatcher_process_buffered_chlos(GoQuicSimpleDispatcher* dispatcher,
+                                           size_t max_new_sessions);
+int quic_dispatcher_has_chlos_buffered(GoQuicSimpleDispatcher* dispatcher);
+void quic_dispatcher_on_loop_lag(GoQuicSimpleDispatcher* dispatcher,
+                                 int64_t lag_us);
+GoQuicDispatcherMetrics* quic_dispatcher_metrics(GoQuicSimpleDispatcher* dispatcher);
+void quic_dispatcher_metrics_snapshot(GoQuicDispatcherMetrics* metrics,
+                                      struct GoQuicDispatcherStats* stats);
 
 SpdyHeaderBlock* initialize_header_block();
 void delete_header_block(SpdyHeaderBlock* map);
@@ -79,6 +101,12 @@ void quic_simple_server_stream_write_headers(GoQuicSimpleServerStream* wrapper,
                                              int* header_value_len,
                                              int is_empty_body);
 void quic_simple_server_stream_write_or_buffer_data(GoQuicSimpleServerStream* wrapper, char* buf, size_t bufsize, int fin);
+// Takes ownership of |buf|, which must be allocated with malloc()
+void quic_simple_server_stream_write_body_buffer(GoQuicSimpleServerStream* wrapper, char* buf, size_t bufsize, int fin);
+void quic_simple_server_stream_enable_body_streaming(GoQuicSimpleServerStream* wrapper);
+void quic_simple_server_stream_mark_body_consumed(GoQuicSimpleServerStream* wrapper, size_t num_bytes);
+void quic_simple_server_stream_stop_reading_body(GoQuicSimpleServerStream* wrapper);
+int quic_simple_server_stream_write_side_closed(GoQuicSimpleServerStream* wrapper);
 void quic_simple_server_stream_write_trailers(GoQuicSimpleServerStream* wrapper,
                                               int header_size,
                                               char* header_keys,
@@ -86,14 +114,23 @@ void quic_simple_server_stream_write_trailers(GoQuicSimpleServerStream* wrapper,
                                               char* header_values,
                                               int* header_value_len);
 
-void go_quic_alarm_fire(GoQuicAlarmGoWrapper* go_quic_alarm);
-int64_t clock_now(QuicClock* clock);
+GoQuicTimerWheel* create_go_quic_timer_wheel();
+void delete_go_quic_timer_wheel(GoQuicTimerWheel* timer_wheel);
+struct GoQuicTimerWheelState* go_quic_timer_wheel_state(GoQuicTimerWheel* timer_wheel);
+void go_quic_timer_wheel_fire_expired(GoQuicTimerWheel* timer_wheel);
 void packet_writer_on_write_complete(GoQuicServerPacketWriter* cb, int rv);
 struct ConnStat quic_server_session_connection_stat(QuicServerSessionBase* sess);
 
 ProofSourceGoquic* init_proof_source_goquic(GoPtr go_proof_source);
 void proof_source_goquic_add_cert(ProofSourceGoquic* proof_source, char* cert_c, size_t cert_sz);
 void proof_source_goquic_build_cert_chain(ProofSourceGoquic* proof_source);
+int proof_source_goquic_set_private_key(ProofSourceGoquic* proof_source, char* der, size_t der_sz);
+void proof_source_goquic_start_signing_threads(ProofSourceGoquic* proof_source, int num_threads);
+void proof_source_goquic_get_signature_cache_stats(ProofSourceGoquic* proof_source, uint64_t* hits, uint64_t* misses);
+void proof_source_goquic_complete_get_proof(GoQuicGetProofJob* job, int ok, char* signature, size_t signature_sz);
+void proof_source_goquic_complete_signed_proof(GoQuicGetProofJob* job);
+void set_async_get_proof(int enabled);
+void enable_buffer_packets_till_chlo(void);
 
 #ifdef __cplusplus
 }
@@ -23,6 +23,7 @@ using base::StringPiece;
 GoQuicClientSession* create_go_quic_client_session_and_initialize(
     GoPtr go_writer,
     GoPtr task_runner,
+    GoQuicTimerWheel* timer_wheel,
     GoPtr go_proof_verifier,
     uint8_t* server_address_ip,
     size_t server_address_len,
@@ -37,7 +38,7 @@ GoQuicClientSession* create_go_quic_client_session_and_initialize(
 
   GoQuicConnectionHelper* helper = new GoQuicConnectionHelper(clock, random_generator);  // Deleted by unique_ptr
 
-  GoQuicAlarmFactory* alarm_factory = new GoQuicAlarmFactory(clock, task_runner); // Deleted by unique_ptr
+  GoQuicAlarmFactory* alarm_factory = new GoQuicAlarmFactory(timer_wheel, task_runner); // Deleted by unique_ptr
 
   QuicPacketWriter* writer = new GoQuicClientPacketWriter(
       go_writer);  // Deleted by ~QuicConnection() because owns_writer is true
@@ -8,6 +8,7 @@
 #ifdef __cplusplus
 #include "go_quic_client_session.h"
 #include "go_quic_spdy_client_stream.h"
+#include "go_quic_timer_wheel.h"
 #include "net/base/ip_endpoint.h"
 #include "net/quic/core/quic_protocol.h"
 using namespace net;
@@ -17,11 +18,13 @@ extern "C" {
 typedef void IPEndPoint;
 typedef void GoQuicClientSession;
 typedef void GoQuicSpdyClientStream;
+typedef void GoQuicTimerWheel;
 #endif
 
 GoQuicClientSession* create_go_quic_client_session_and_initialize(
     GoPtr go_writer,
     GoPtr task_runner,
+    GoQuicTimerWheel* timer_wheel,
     GoPtr go_proof_verifier,
     uint8_t* server_address_ip,
     size_t server_address_len,
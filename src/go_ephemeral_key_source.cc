@@ -12,6 +12,8 @@ std::string GoEphemeralKeySource::CalculateForwardSecureKey(
     net::QuicTime now,
     base::StringPiece peer_public_value,
     std::string* public_value) {
+  base::AutoLock locked(lock_);
+
   // Cache forward_secure_key_exchange for 10 seconds
   if (forward_secure_key_exchange_.get() == nullptr ||
       (now - key_created_time_).ToSeconds() > 10) {
@@ -4,9 +4,12 @@
 #include "net/quic/core/crypto/key_exchange.h"
 #include "net/quic/core/crypto/ephemeral_key_source.h"
 #include "net/quic/core/quic_time.h"
+#include "base/synchronization/lock.h"
 
 namespace net {
 
+// Shared by every dispatcher through the crypto config, so the cached key pair
+// is guarded by a lock.
 class GoEphemeralKeySource : public EphemeralKeySource {
  public:
   GoEphemeralKeySource();
@@ -19,6 +22,7 @@ class GoEphemeralKeySource : public EphemeralKeySource {
       std::string* public_value) override;
 
  private:
+  base::Lock lock_;
   std::unique_ptr<net::KeyExchange> forward_secure_key_exchange_;
   QuicTime key_created_time_;
 };
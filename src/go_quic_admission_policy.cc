@@ -0,0 +1,73 @@
+#include "go_quic_admission_policy.h"
+
+namespace net {
+
+namespace {
+
+// Enough sets that unrelated prefixes rarely share one; 48KB of buckets.
+const size_t kChloRateLimiterBuckets = 2048;
+
+}  // namespace
+
+GoQuicAdmissionController::GoQuicAdmissionController(
+    const GoQuicDispatcherConfig& config,
+    uint64_t seed)
+    : max_sessions_(config.Max_sessions),
+      max_loop_lag_(QuicTime::Delta::FromMicroseconds(config.Max_loop_lag_us)) {
+  if (config.Chlo_rate_per_prefix > 0) {
+    double burst = config.Chlo_burst_per_prefix > 0
+                       ? config.Chlo_burst_per_prefix
+                       : config.Chlo_rate_per_prefix;
+    rate_limiter_.reset(new GoQuicPrefixRateLimiter(
+        24, 48, config.Chlo_rate_per_prefix, burst, kChloRateLimiterBuckets,
+        seed));
+  }
+}
+
+GoQuicAdmissionController::~GoQuicAdmissionController() {}
+
+// static
+std::unique_ptr<GoQuicAdmissionPolicy> GoQuicAdmissionController::Create(
+    const GoQuicDispatcherConfig& config,
+    uint64_t seed) {
+  if (config.Max_sessions == 0 && config.Max_loop_lag_us <= 0 &&
+      config.Chlo_rate_per_prefix <= 0) {
+    return nullptr;
+  }
+  return std::unique_ptr<GoQuicAdmissionPolicy>(
+      new GoQuicAdmissionController(config, seed));
+}
+
+bool GoQuicAdmissionController::Admit(const IPEndPoint& client_address,
+                                      QuicTime now,
+                                      size_t num_sessions,
+                                      QuicTime::Delta loop_lag,
+                                      std::string* error_details) {
+  // The rate limiter goes last, so that a CHLO shed for load does not also
+  // spend a token of its client.
+  if (!CanCreateSession(num_sessions, loop_lag, error_details)) {
+    return false;
+  }
+  if (rate_limiter_ != nullptr &&
+      !rate_limiter_->Allow(client_address.address(), now)) {
+    *error_details = "Too many connection attempts";
+    return false;
+  }
+  return true;
+}
+
+bool GoQuicAdmissionController::CanCreateSession(size_t num_sessions,
+                                                 QuicTime::Delta loop_lag,
+                                                 std::string* error_details) {
+  if (max_sessions_ > 0 && num_sessions >= max_sessions_) {
+    *error_details = "Too many sessions";
+    return false;
+  }
+  if (max_loop_lag_ > QuicTime::Delta::Zero() && loop_lag > max_loop_lag_) {
+    *error_details = "Server overloaded";
+    return false;
+  }
+  return true;
+}
+
+}  // namespace net
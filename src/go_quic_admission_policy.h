@@ -0,0 +1,79 @@
+#ifndef GO_QUIC_ADMISSION_POLICY_H_
+#define GO_QUIC_ADMISSION_POLICY_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+
+#include "base/macros.h"
+#include "net/base/ip_endpoint.h"
+#include "net/quic/core/quic_time.h"
+
+#include "go_quic_prefix_rate_limiter.h"
+#include "go_structs.h"
+
+namespace net {
+
+// Decides whether the dispatcher creates a session for the CHLO of a new
+// connection. A CHLO that is turned away costs a CONNECTION_CLOSE and a
+// time-wait entry, instead of a session and a handshake.
+class GoQuicAdmissionPolicy {
+ public:
+  virtual ~GoQuicAdmissionPolicy() {}
+
+  // |num_sessions| is the number of open sessions of the dispatcher, and
+  // |loop_lag| its smoothed event loop lag. Returns false, with the reason in
+  // |error_details|, to reject the connection.
+  virtual bool Admit(const IPEndPoint& client_address,
+                     QuicTime now,
+                     size_t num_sessions,
+                     QuicTime::Delta loop_lag,
+                     std::string* error_details) = 0;
+
+  // Asked again when a CHLO admitted earlier, but buffered by the per-loop
+  // session limit, is about to create its session. Only load based checks
+  // belong here; the client has already been charged by Admit().
+  virtual bool CanCreateSession(size_t num_sessions,
+                                QuicTime::Delta loop_lag,
+                                std::string* error_details) {
+    return true;
+  }
+};
+
+// Policy built from the GoQuicDispatcherConfig admission settings: a cap on
+// open sessions, a cap on event loop lag, and a CHLO token bucket per source
+// address prefix. Each check is disabled when its setting is zero.
+class GoQuicAdmissionController : public GoQuicAdmissionPolicy {
+ public:
+  GoQuicAdmissionController(const GoQuicDispatcherConfig& config,
+                            uint64_t seed);
+  ~GoQuicAdmissionController() override;
+
+  // Returns null if the configuration enables no check.
+  static std::unique_ptr<GoQuicAdmissionPolicy> Create(
+      const GoQuicDispatcherConfig& config,
+      uint64_t seed);
+
+  // GoQuicAdmissionPolicy implementation.
+  bool Admit(const IPEndPoint& client_address,
+             QuicTime now,
+             size_t num_sessions,
+             QuicTime::Delta loop_lag,
+             std::string* error_details) override;
+  bool CanCreateSession(size_t num_sessions,
+                        QuicTime::Delta loop_lag,
+                        std::string* error_details) override;
+
+ private:
+  const size_t max_sessions_;
+  const QuicTime::Delta max_loop_lag_;
+  std::unique_ptr<GoQuicPrefixRateLimiter> rate_limiter_;
+
+  DISALLOW_COPY_AND_ASSIGN(GoQuicAdmissionController);
+};
+
+}  // namespace net
+
+#endif  // GO_QUIC_ADMISSION_POLICY_H_
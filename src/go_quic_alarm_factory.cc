@@ -1,30 +1,60 @@
 #include "go_quic_alarm_factory.h"
-#include "go_quic_alarm_go_wrapper.h"
+
+#include "go_functions.h"
 
 namespace net {
 
-GoQuicAlarmFactory::GoQuicAlarmFactory(QuicClock* clock, GoPtr task_runner)
-    : clock_(clock), 
-      task_runner_(task_runner) {}
+namespace {
+
+// QuicAlarm must stay the first base: QuicArenaScopedPtr converts between
+// pointer types without adjusting them.
+class GoQuicAlarm : public QuicAlarm, public GoQuicTimerWheel::Timer {
+ public:
+  GoQuicAlarm(GoQuicTimerWheel* timer_wheel,
+              QuicArenaScopedPtr<Delegate> delegate)
+      : QuicAlarm(std::move(delegate)), Timer(timer_wheel) {}
+
+ protected:
+  void SetImpl() override {
+    if (wheel() != nullptr) {
+      wheel()->Schedule(this, deadline());
+    }
+  }
+
+  void CancelImpl() override {
+    if (wheel() != nullptr) {
+      wheel()->Cancel(this);
+    }
+  }
+
+  void OnExpire() override { Fire(); }
+};
+
+}  // namespace
+
+GoQuicAlarmFactory::GoQuicAlarmFactory(GoQuicTimerWheel* timer_wheel,
+                                       GoPtr task_runner)
+    : timer_wheel_(timer_wheel), task_runner_(task_runner) {}
+
 GoQuicAlarmFactory::~GoQuicAlarmFactory() {
   ReleaseTaskRunner_C(task_runner_);
 }
 
 QuicAlarm* GoQuicAlarmFactory::CreateAlarm(
     QuicAlarm::Delegate* delegate) {
-  return new GoQuicAlarmGoWrapper(clock_, task_runner_,
-                                  QuicArenaScopedPtr<QuicAlarm::Delegate>(delegate));  // Should be deleted by caller
+  return new GoQuicAlarm(timer_wheel_,
+                         QuicArenaScopedPtr<QuicAlarm::Delegate>(delegate));  // Should be deleted by caller
 }
 
 QuicArenaScopedPtr<QuicAlarm> GoQuicAlarmFactory::CreateAlarm(
     QuicArenaScopedPtr<QuicAlarm::Delegate> delegate,
     QuicConnectionArena* arena) {
   if (arena != nullptr) {
-    return arena->New<GoQuicAlarmGoWrapper>(clock_, task_runner_, std::move(delegate));
+    return arena->New<GoQuicAlarm>(timer_wheel_, std::move(delegate));
   } else {
     return QuicArenaScopedPtr<QuicAlarm>(
-        new GoQuicAlarmGoWrapper(clock_, task_runner_, std::move(delegate)));
+        new GoQuicAlarm(timer_wheel_, std::move(delegate)));
   }
 }
 
-}
+}  // namespace net
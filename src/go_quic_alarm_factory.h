@@ -2,15 +2,16 @@
 #define GO_QUIC_ALARM_FACTORY_H_
 
 #include "go_structs.h"
+#include "go_quic_timer_wheel.h"
 #include "net/quic/core/quic_alarm.h"
 #include "net/quic/core/quic_alarm_factory.h"
-#include "net/quic/core/quic_clock.h"
 
 namespace net {
 
+// Creates alarms driven by a GoQuicTimerWheel.
 class GoQuicAlarmFactory : public QuicAlarmFactory {
  public:
-  explicit GoQuicAlarmFactory(QuicClock* clock, GoPtr task_runner);
+  GoQuicAlarmFactory(GoQuicTimerWheel* timer_wheel, GoPtr task_runner);
   ~GoQuicAlarmFactory() override;
 
   // QuicAlarmFactory interface.
@@ -20,7 +21,7 @@ class GoQuicAlarmFactory : public QuicAlarmFactory {
       QuicConnectionArena* arena) override;
 
  private:
-  QuicClock* clock_;   // Not owned ( may be owned by connection helper )  TODO(hodduc): should ref-counted?
+  GoQuicTimerWheel* timer_wheel_;  // Owned by the Go TaskRunner
   GoPtr task_runner_;
 
   DISALLOW_COPY_AND_ASSIGN(GoQuicAlarmFactory);
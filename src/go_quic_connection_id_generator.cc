@@ -0,0 +1,37 @@
+#include "go_quic_connection_id_generator.h"
+
+#include "base/logging.h"
+#include "net/quic/core/crypto/quic_random.h"
+
+namespace net {
+
+GoQuicConnectionIdGenerator::GoQuicConnectionIdGenerator(
+    QuicRandom* random,
+    const GoQuicDispatcherConfig& config)
+    : random_(random),
+      shard_index_(config.Shard_index),
+      num_shards_(config.Num_shards > 0 ? config.Num_shards : 1),
+      use_server_id_(config.Use_server_id != 0),
+      server_id_(config.Server_id) {
+  DCHECK_LT(shard_index_, num_shards_);
+}
+
+QuicConnectionId GoQuicConnectionIdGenerator::GenerateConnectionId() const {
+  uint64_t id = random_->RandUint64();
+
+  // Round the low 32 bits down to a multiple of |num_shards_| and add the
+  // shard index. If that overflows 32 bits, step back by one period.
+  uint64_t low = id & 0xffffffffu;
+  low = low - low % num_shards_ + shard_index_;
+  if (low > 0xffffffffu) {
+    low -= num_shards_;
+  }
+  id = (id & ~static_cast<uint64_t>(0xffffffffu)) | low;
+
+  if (use_server_id_) {
+    id = (id & 0x0000ffffffffffffu) | (static_cast<uint64_t>(server_id_) << 48);
+  }
+  return id;
+}
+
+}  // namespace net
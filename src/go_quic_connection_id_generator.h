@@ -0,0 +1,35 @@
+#ifndef GO_QUIC_CONNECTION_ID_GENERATOR_H_
+#define GO_QUIC_CONNECTION_ID_GENERATOR_H_
+
+#include "net/quic/core/quic_protocol.h"
+#include "go_structs.h"
+
+namespace net {
+
+class QuicRandom;
+
+// Generates server-chosen connection IDs that route back to the dispatcher
+// which issued them. The low 32 bits are random but congruent to the shard
+// index modulo the number of shards, which is what the Go reader and the
+// reuseport steering program shard on. If a server ID is configured it takes
+// the top 16 bits, so that an L4 load balancer can pick the host without
+// keeping any state.
+class GoQuicConnectionIdGenerator {
+ public:
+  GoQuicConnectionIdGenerator(QuicRandom* random,
+                              const GoQuicDispatcherConfig& config);
+
+  QuicConnectionId GenerateConnectionId() const;
+
+ private:
+  QuicRandom* random_;  // Unowned.
+
+  uint32_t shard_index_;
+  uint32_t num_shards_;
+  bool use_server_id_;
+  uint16_t server_id_;
+};
+
+}  // namespace net
+
+#endif  // GO_QUIC_CONNECTION_ID_GENERATOR_H_
@@ -1,5 +1,7 @@
 #include "go_quic_dispatcher.h"
 
+#include <string.h>
+
 #include "go_functions.h"
 
 #include "base/debug/stack_trace.h"
@@ -183,6 +185,24 @@ class ChloValidator : public ChloExtractor::Delegate {
   string error_details_;
 };
 
+// Records the version of a CHLO.
+class ChloVersionRecorder : public ChloExtractor::Delegate {
+ public:
+  ChloVersionRecorder() : version_(QUIC_VERSION_UNSUPPORTED) {}
+
+  // ChloExtractor::Delegate implementation.
+  void OnChlo(QuicVersion version,
+              QuicConnectionId connection_id,
+              const CryptoHandshakeMessage& chlo) override {
+    version_ = version;
+  }
+
+  QuicVersion version() const { return version_; }
+
+ private:
+  QuicVersion version_;
+};
+
 }  // namespace
 
 GoQuicDispatcher::GoQuicDispatcher(
@@ -210,8 +230,10 @@ GoQuicDispatcher::GoQuicDispatcher(
               /*unused*/ QuicTime::Zero(),
               Perspective::IS_SERVER),
       last_error_(QUIC_NO_ERROR),
+      go_quic_dispatcher_(go_quic_dispatcher),
+      limit_new_sessions_per_event_loop_(false),
       new_sessions_allowed_per_event_loop_(0u),
-      go_quic_dispatcher_(go_quic_dispatcher) {
+      smoothed_loop_lag_(QuicTime::Delta::Zero()) {
   framer_.set_visitor(this);
 }
 
@@ -230,6 +252,12 @@ void GoQuicDispatcher::InitializeWithWriter(QuicPacketWriter* writer) {
 void GoQuicDispatcher::ProcessPacket(const IPEndPoint& server_address,
                                      const IPEndPoint& client_address,
                                      const QuicReceivedPacket& packet) {
+  metrics_.Increment(GoQuicDispatcherMetrics::kPacketsReceived);
+  if (unknown_packet_rate_limiter_ != nullptr &&
+      ShouldRateLimitPacket(client_address, packet)) {
+    metrics_.Increment(GoQuicDispatcherMetrics::kPacketsRateLimited);
+    return;
+  }
   current_server_address_ = server_address;
   current_client_address_ = client_address;
   current_packet_ = &packet;
@@ -241,6 +269,25 @@ void GoQuicDispatcher::ProcessPacket(const IPEndPoint& server_address,
   //                and log somehow.  Maybe expose as a varz.
 }
 
+bool GoQuicDispatcher::ShouldRateLimitPacket(
+    const IPEndPoint& client_address,
+    const QuicReceivedPacket& packet) {
+  // Peek at the connection ID, which follows the public flags, in host byte
+  // order like QuicFramer reads it. The 0x08 flag marks a full length ID;
+  // older clients set 0x04 along with it.
+  const uint8_t kFullConnectionIdFlag = 0x08;
+  QuicConnectionId connection_id;
+  if (packet.length() >= 1 + sizeof(connection_id) &&
+      (packet.data()[0] & kFullConnectionIdFlag) != 0) {
+    memcpy(&connection_id, packet.data() + 1, sizeof(connection_id));
+    if (session_map_.find(connection_id) != session_map_.end()) {
+      return false;
+    }
+  }
+  return !unknown_packet_rate_limiter_->Allow(client_address.address(),
+                                              packet.receipt_time());
+}
+
 bool GoQuicDispatcher::OnUnauthenticatedPublicHeader(
     const QuicPacketPublicHeader& header) {
   current_connection_id_ = header.connection_id;
@@ -300,6 +347,7 @@ bool GoQuicDispatcher::OnUnauthenticatedPublicHeader(
       }
       // Since the version is not supported, send a version negotiation
       // packet and stop processing the current packet.
+      metrics_.Increment(GoQuicDispatcherMetrics::kVersionNegotiations);
       time_wait_list_manager()->SendVersionNegotiationPacket(
           connection_id, GetSupportedVersions(), current_server_address_,
           current_client_address_);
@@ -442,6 +490,34 @@ void GoQuicDispatcher::OnCanWrite() {
   }
 }
 
+void GoQuicDispatcher::FlushWrites() {
+  static_cast<GoQuicServerPacketWriter*>(writer_.get())->Flush();
+
+  // Gauges are refreshed once per event loop iteration rather than on every
+  // change.
+  metrics_.Set(GoQuicDispatcherMetrics::kSessions, session_map_.size());
+  metrics_.Set(GoQuicDispatcherMetrics::kTimeWaitConnections,
+               time_wait_list_manager_->num_connections());
+}
+
+void GoQuicDispatcher::SetTimeWaitListMaxConnections(int max_connections) {
+  time_wait_list_manager_->set_max_connections(max_connections);
+}
+
+void GoQuicDispatcher::OnLoopLag(QuicTime::Delta lag) {
+  // Same weight as the smoothed RTT, so that a single slow iteration does not
+  // start shedding load.
+  smoothed_loop_lag_ = QuicTime::Delta::FromMicroseconds(
+      (7 * smoothed_loop_lag_.ToMicroseconds() + lag.ToMicroseconds()) / 8);
+  metrics_.Set(GoQuicDispatcherMetrics::kLoopLagUs,
+               smoothed_loop_lag_.ToMicroseconds());
+}
+
+void GoQuicDispatcher::OnWriterUnblocked() {
+  // Runs OnCanWrite() on this dispatcher, which drains write_blocked_list_.
+  static_cast<GoQuicServerPacketWriter*>(writer_.get())->OnWriteComplete(0);
+}
+
 bool GoQuicDispatcher::HasPendingWrites() const {
   return !write_blocked_list_.empty();
 }
@@ -480,6 +556,7 @@ void GoQuicDispatcher::OnConnectionClosed(QuicConnectionId connection_id,
                                    QuicTime::Delta::Zero());
   }
   closed_session_list_.push_back(it->second);
+  metrics_.Increment(GoQuicDispatcherMetrics::kSessionsClosed);
   const bool should_close_statelessly =
       (error == QUIC_CRYPTO_HANDSHAKE_STATELESS_REJECT);
   CleanUpSession(it, should_close_statelessly);
@@ -625,8 +702,18 @@ void GoQuicDispatcher::ProcessBufferedChlos(size_t max_connections_to_create) {
     if (packets.empty()) {
       return;
     }
+    // The CHLO was admitted when it was buffered, but sessions may have been
+    // created since.
+    string error_details;
+    if (admission_policy_ != nullptr &&
+        !admission_policy_->CanCreateSession(
+            session_map_.size(), smoothed_loop_lag_, &error_details)) {
+      ShedBufferedChlo(connection_id, packets, error_details);
+      continue;
+    }
     QuicServerSessionBase* session =
         CreateQuicSession(connection_id, packets.front().client_address);
+    metrics_.Increment(GoQuicDispatcherMetrics::kSessionsCreated);
     DVLOG(1) << "Created new session for " << connection_id;
     session_map_.insert(std::make_pair(connection_id, session));
     DeliverPacketsToSession(packets, session);
@@ -652,7 +739,9 @@ void GoQuicDispatcher::OnBufferPacketFailure(EnqueuePacketResult result,
            << " because of " << result;
 }
 
-void GoQuicDispatcher::OnConnectionRejectedStatelessly() {}
+void GoQuicDispatcher::OnConnectionRejectedStatelessly() {
+  metrics_.Increment(GoQuicDispatcherMetrics::kStatelessRejects);
+}
 
 void GoQuicDispatcher::OnConnectionClosedStatelessly(QuicErrorCode error) {}
 
@@ -682,13 +771,12 @@ void GoQuicDispatcher::BufferEarlyPacket(QuicConnectionId connection_id) {
 void GoQuicDispatcher::ProcessChlo() {
 
   QUIC_BUG_IF(!FLAGS_quic_buffer_packet_till_chlo &&
-              FLAGS_quic_limit_num_new_sessions_per_epoll_loop)
+              limit_new_sessions_per_event_loop_)
       << "Try to limit connection creation per epoll event while not "
          "supporting packet buffer. "
-         "--quic_limit_num_new_sessions_per_epoll_loop = true "
          "--quic_buffer_packet_till_chlo = false";
 
-  if (FLAGS_quic_limit_num_new_sessions_per_epoll_loop &&
+  if (limit_new_sessions_per_event_loop_ &&
       FLAGS_quic_buffer_packet_till_chlo &&
       new_sessions_allowed_per_event_loop_ <= 0) {
     // Can't create new session any more. Wait till next event loop.
@@ -701,8 +789,11 @@ void GoQuicDispatcher::ProcessChlo() {
           current_client_address_, /*is_chlo=*/true);
       if (rs != EnqueuePacketResult::SUCCESS) {
         OnBufferPacketFailure(rs, current_connection_id_);
-      } else if (is_new_connection) {
-        OnNewConnectionAdded(current_connection_id_);
+      } else {
+        metrics_.Increment(GoQuicDispatcherMetrics::kChlosBuffered);
+        if (is_new_connection) {
+          OnNewConnectionAdded(current_connection_id_);
+        }
       }
     }
     return;
@@ -711,6 +802,7 @@ void GoQuicDispatcher::ProcessChlo() {
   // Creates a new session and process all buffered packets for this connection.
   QuicServerSessionBase* session =
       CreateQuicSession(current_connection_id_, current_client_address_);
+  metrics_.Increment(GoQuicDispatcherMetrics::kSessionsCreated);
   if (FLAGS_quic_enforce_mtu_limit &&
       current_packet().potentially_small_mtu()) {
     session->connection()->set_largest_packet_size_supported(
@@ -732,7 +824,7 @@ void GoQuicDispatcher::ProcessChlo() {
   // Do this even when flag is off because there might be still some packets
   // buffered in the store before flag is turned off.
   DeliverPacketsToSession(packets, session);
-  if (FLAGS_quic_limit_num_new_sessions_per_epoll_loop &&
+  if (limit_new_sessions_per_event_loop_ &&
       FLAGS_quic_buffer_packet_till_chlo) {
     --new_sessions_allowed_per_event_loop_;
   }
@@ -810,6 +902,12 @@ void GoQuicDispatcher::MaybeRejectStatelessly(QuicConnectionId connection_id,
                                        header.packet_number);
       return;
     }
+    string error_details;
+    if (!AdmitChlo(&error_details)) {
+      ShedChlo(connection_id, current_server_address_, current_client_address_,
+               *current_packet_, header.packet_number, error_details);
+      return;
+    }
     ProcessUnauthenticatedHeaderFate(kFateProcess, connection_id,
                                      header.packet_number);
     return;
@@ -851,6 +949,13 @@ void GoQuicDispatcher::MaybeRejectStatelessly(QuicConnectionId connection_id,
     return;
   }
 
+  string error_details;
+  if (!AdmitChlo(&error_details)) {
+    ShedChlo(connection_id, current_server_address_, current_client_address_,
+             *current_packet_, header.packet_number, error_details);
+    return;
+  }
+
   // Continue stateless rejector processing
   std::unique_ptr<StatelessRejectorProcessDoneCallback> cb(
       new StatelessRejectorProcessDoneCallback(
@@ -858,6 +963,62 @@ void GoQuicDispatcher::MaybeRejectStatelessly(QuicConnectionId connection_id,
   StatelessRejector::Process(std::move(rejector), std::move(cb));
 }
 
+bool GoQuicDispatcher::AdmitChlo(string* error_details) {
+  if (admission_policy_ == nullptr) {
+    return true;
+  }
+  return admission_policy_->Admit(
+      current_client_address_, helper_->GetClock()->ApproximateNow(),
+      session_map_.size(), smoothed_loop_lag_, error_details);
+}
+
+void GoQuicDispatcher::ShedChlo(QuicConnectionId connection_id,
+                                const IPEndPoint& server_address,
+                                const IPEndPoint& client_address,
+                                const QuicReceivedPacket& packet,
+                                QuicPacketNumber packet_number,
+                                const string& error_details) {
+  DVLOG(1) << "Shedding connection " << connection_id << " from "
+           << client_address.ToString() << ": " << error_details;
+  metrics_.Increment(GoQuicDispatcherMetrics::kChlosShed);
+  StatelessConnectionTerminator terminator(connection_id, &framer_, helper(),
+                                           time_wait_list_manager_.get());
+  terminator.CloseConnection(QUIC_HANDSHAKE_FAILED, error_details);
+  OnConnectionClosedStatelessly(QUIC_HANDSHAKE_FAILED);
+  // The terminator has added the connection to time-wait, which answers this
+  // and any retransmitted CHLO with the close.
+  DCHECK(time_wait_list_manager_->IsConnectionIdInTimeWait(connection_id));
+  time_wait_list_manager_->ProcessPacket(server_address, client_address,
+                                         connection_id, packet_number, packet);
+}
+
+void GoQuicDispatcher::ShedBufferedChlo(
+    QuicConnectionId connection_id,
+    const std::list<BufferedPacket>& packets,
+    const string& error_details) {
+  // The close is built for the CHLO's version, which is only known from
+  // parsing it again.
+  for (const BufferedPacket& packet : packets) {
+    ChloVersionRecorder recorder;
+    if (ChloExtractor::Extract(*packet.packet, GetSupportedVersions(),
+                               &recorder) &&
+        recorder.version() != QUIC_VERSION_UNSUPPORTED) {
+      framer_.set_version(recorder.version());
+      // Packet numbers only matter for public resets, which are not sent.
+      ShedChlo(connection_id, packet.server_address, packet.client_address,
+               *packet.packet, kInvalidPacketNumber, error_details);
+      return;
+    }
+  }
+
+  // Not expected, as only connections with a CHLO are delivered; fall back to
+  // public resets like for expired packets.
+  metrics_.Increment(GoQuicDispatcherMetrics::kChlosShed);
+  time_wait_list_manager_->AddConnectionIdToTimeWait(
+      connection_id, framer_.version(),
+      /*connection_rejected_statelessly=*/false, nullptr);
+}
+
 void GoQuicDispatcher::OnStatelessRejectorProcessDone(
     std::unique_ptr<StatelessRejector> rejector,
     QuicPacketNumber packet_number,
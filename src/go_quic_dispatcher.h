@@ -8,6 +8,7 @@
 #ifndef GO_QUIC_DISPATCHER_H_
 #define GO_QUIC_DISPATCHER_H_
 
+#include <list>
 #include <unordered_map>
 #include <vector>
 
@@ -22,6 +23,9 @@
 #include "net/quic/core/quic_protocol.h"
 #include "net/quic/core/quic_server_session_base.h"
 
+#include "go_quic_admission_policy.h"
+#include "go_quic_dispatcher_metrics.h"
+#include "go_quic_prefix_rate_limiter.h"
 #include "go_quic_process_packet_interface.h"
 #include "go_quic_time_wait_list_manager.h"
 #include "stateless_rejector.h"
@@ -71,6 +75,45 @@ class GoQuicDispatcher : public QuicServerSessionBase::Visitor,
   // Returns true if there's anything in the blocked writer list.
   virtual bool HasPendingWrites() const;
 
+  // Hands every packet buffered by the server writer over to Go in one batch.
+  // Should be called at the end of each event loop iteration.
+  void FlushWrites();
+
+  // Called once Go's egress queue has drained after the server writer
+  // reported WRITE_STATUS_BLOCKED. Lets blocked connections write again.
+  void OnWriterUnblocked();
+
+  // See GoQuicTimeWaitListManager::set_max_connections(). Must be called
+  // after InitializeWithWriter().
+  void SetTimeWaitListMaxConnections(int max_connections);
+
+  // Makes ProcessChlo() buffer CHLOs once the budget given to
+  // ProcessBufferedChlos() for the current event loop is spent. Requires
+  // FLAGS_quic_buffer_packet_till_chlo.
+  void set_limit_new_sessions_per_event_loop(bool limit) {
+    limit_new_sessions_per_event_loop_ = limit;
+  }
+
+  // Sets the policy consulted before a session is created for a new
+  // connection. Null admits every connection.
+  void set_admission_policy(std::unique_ptr<GoQuicAdmissionPolicy> policy) {
+    admission_policy_ = std::move(policy);
+  }
+
+  // Sets the limiter applied to packets which do not belong to an open
+  // session, before they are parsed. Null disables it.
+  void set_unknown_packet_rate_limiter(
+      std::unique_ptr<GoQuicPrefixRateLimiter> limiter) {
+    unknown_packet_rate_limiter_ = std::move(limiter);
+  }
+
+  // Feeds one sample of how long an event waited for the event loop into
+  // the smoothed loop lag seen by the admission policy.
+  void OnLoopLag(QuicTime::Delta lag);
+
+  // Aggregated counters. Safe to read from any thread.
+  GoQuicDispatcherMetrics* metrics() { return &metrics_; }
+
   // Sends ConnectionClose frames to all connected clients.
   void Shutdown();
 
@@ -278,6 +321,11 @@ class GoQuicDispatcher : public QuicServerSessionBase::Visitor,
 
   bool HandlePacketForTimeWait(const QuicPacketPublicHeader& header);
 
+  // Whether |packet| is rejected by |unknown_packet_rate_limiter_|. Packets
+  // of open sessions always pass, without being charged.
+  bool ShouldRateLimitPacket(const IPEndPoint& client_address,
+                             const QuicReceivedPacket& packet);
+
   // Attempts to reject the connection statelessly, if stateless rejects are
   // possible and if the current packet contains a CHLO message.  Determines a
   // fate which describes what subsequent processing should be performed on the
@@ -285,6 +333,27 @@ class GoQuicDispatcher : public QuicServerSessionBase::Visitor,
   void MaybeRejectStatelessly(QuicConnectionId connection_id,
                               const QuicPacketHeader& header);
 
+  // Asks the admission policy whether the current packet, a CHLO of a new
+  // connection, may create a session.
+  bool AdmitChlo(std::string* error_details);
+
+  // Closes the connection of a CHLO refused by the admission policy and
+  // moves it to time-wait, answering |packet| with the close. The framer
+  // must be set to the connection's version.
+  void ShedChlo(QuicConnectionId connection_id,
+                const IPEndPoint& server_address,
+                const IPEndPoint& client_address,
+                const QuicReceivedPacket& packet,
+                QuicPacketNumber packet_number,
+                const std::string& error_details);
+
+  // Sheds a connection whose CHLO was admitted and buffered, but which the
+  // admission policy no longer lets create a session.
+  void ShedBufferedChlo(
+      QuicConnectionId connection_id,
+      const std::list<QuicBufferedPacketStore::BufferedPacket>& packets,
+      const std::string& error_details);
+
   // Deliver |packets| to |session| for further processing.
   void DeliverPacketsToSession(
       const std::list<QuicBufferedPacketStore::BufferedPacket>& packets,
@@ -307,11 +376,19 @@ class GoQuicDispatcher : public QuicServerSessionBase::Visitor,
     new_sessions_allowed_per_event_loop_ = new_sessions_allowed_per_event_loop;
   }
 
+  // Declared first so that it outlives everything that reports to it,
+  // including the alarm factory and its timer wheel.
+  GoQuicDispatcherMetrics metrics_;
+
   const QuicConfig& config_;
 
   const QuicCryptoServerConfig* crypto_config_;
 
-  // The cache for most recently compressed certs.
+  // The cache for most recently compressed certs. Unlike |crypto_config_| it
+  // is not shared between dispatchers: libquic calls into it without any
+  // locking. It is keyed by the client's cached/common cert set hashes, which
+  // only take a handful of distinct values, so a per-dispatcher copy stays
+  // small and warms up after a few handshakes.
   QuicCompressedCertsCache compressed_certs_cache_;
 
   // The list of connections waiting to write.
@@ -361,10 +438,20 @@ class GoQuicDispatcher : public QuicServerSessionBase::Visitor,
 
   GoPtr go_quic_dispatcher_;
 
+  // Whether ProcessChlo() only creates new_sessions_allowed_per_event_loop_
+  // sessions per event loop. Replaces the process-wide
+  // FLAGS_quic_limit_num_new_sessions_per_epoll_loop, so that dispatchers
+  // which never call ProcessBufferedChlos() are not limited to zero.
+  bool limit_new_sessions_per_event_loop_;
+
   // A backward counter of how many new sessions can be create within current
   // event loop. When reaches 0, it means can't create sessions for now.
   int16_t new_sessions_allowed_per_event_loop_;
 
+  std::unique_ptr<GoQuicAdmissionPolicy> admission_policy_;
+  std::unique_ptr<GoQuicPrefixRateLimiter> unknown_packet_rate_limiter_;
+  QuicTime::Delta smoothed_loop_lag_;
+
   DISALLOW_COPY_AND_ASSIGN(GoQuicDispatcher);
 };
 
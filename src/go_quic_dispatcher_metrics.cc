@@ -0,0 +1,33 @@
+#include "go_quic_dispatcher_metrics.h"
+
+namespace net {
+
+GoQuicDispatcherMetrics::GoQuicDispatcherMetrics() {
+  for (int i = 0; i < kNumCounters; i++) {
+    counters_[i].store(0, std::memory_order_relaxed);
+  }
+  for (int i = 0; i < kNumGauges; i++) {
+    gauges_[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+void GoQuicDispatcherMetrics::Snapshot(GoQuicDispatcherStats* stats) const {
+  const std::memory_order relaxed = std::memory_order_relaxed;
+  stats->Packets_received = counters_[kPacketsReceived].load(relaxed);
+  stats->Packets_sent = counters_[kPacketsSent].load(relaxed);
+  stats->Sessions_created = counters_[kSessionsCreated].load(relaxed);
+  stats->Sessions_closed = counters_[kSessionsClosed].load(relaxed);
+  stats->Chlos_buffered = counters_[kChlosBuffered].load(relaxed);
+  stats->Stateless_rejects = counters_[kStatelessRejects].load(relaxed);
+  stats->Version_negotiations = counters_[kVersionNegotiations].load(relaxed);
+  stats->Write_blocks = counters_[kWriteBlocks].load(relaxed);
+  stats->Alarms_fired = counters_[kAlarmsFired].load(relaxed);
+  stats->Chlos_shed = counters_[kChlosShed].load(relaxed);
+  stats->Packets_rate_limited = counters_[kPacketsRateLimited].load(relaxed);
+
+  stats->Sessions = gauges_[kSessions].load(relaxed);
+  stats->Time_wait_connections = gauges_[kTimeWaitConnections].load(relaxed);
+  stats->Loop_lag_us = gauges_[kLoopLagUs].load(relaxed);
+}
+
+}  // namespace net
@@ -0,0 +1,66 @@
+#ifndef GO_QUIC_DISPATCHER_METRICS_H_
+#define GO_QUIC_DISPATCHER_METRICS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
+#include "base/macros.h"
+#include "go_structs.h"
+
+namespace net {
+
+// Aggregated counters of one dispatcher. They are only updated on the
+// dispatcher's thread, but Snapshot() may be called from any thread: every
+// value is a relaxed atomic, so reading them takes no lock and costs the
+// dispatcher nothing beyond a plain store.
+class GoQuicDispatcherMetrics {
+ public:
+  enum Counter {
+    kPacketsReceived,
+    kPacketsSent,
+    kSessionsCreated,
+    kSessionsClosed,
+    kChlosBuffered,
+    kStatelessRejects,
+    kVersionNegotiations,
+    kWriteBlocks,
+    kAlarmsFired,
+    kChlosShed,
+    kPacketsRateLimited,
+    kNumCounters,
+  };
+
+  enum Gauge {
+    kSessions,
+    kTimeWaitConnections,
+    kLoopLagUs,
+    kNumGauges,
+  };
+
+  GoQuicDispatcherMetrics();
+
+  // Must only be called on the dispatcher's thread.
+  void Increment(Counter counter, uint64_t n = 1) {
+    std::atomic<uint64_t>& value = counters_[counter];
+    value.store(value.load(std::memory_order_relaxed) + n,
+                std::memory_order_relaxed);
+  }
+
+  void Set(Gauge gauge, uint64_t value) {
+    gauges_[gauge].store(value, std::memory_order_relaxed);
+  }
+
+  void Snapshot(GoQuicDispatcherStats* stats) const;
+
+ private:
+  std::atomic<uint64_t> counters_[kNumCounters];
+  std::atomic<uint64_t> gauges_[kNumGauges];
+
+  DISALLOW_COPY_AND_ASSIGN(GoQuicDispatcherMetrics);
+};
+
+}  // namespace net
+
+#endif  // GO_QUIC_DISPATCHER_METRICS_H_
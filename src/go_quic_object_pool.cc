@@ -0,0 +1,121 @@
+#include "go_quic_object_pool.h"
+
+#include <stddef.h>
+
+#include <algorithm>
+#include <utility>
+
+#include "base/logging.h"
+
+namespace net {
+
+namespace {
+
+size_t AlignedSize(size_t size) {
+  const size_t kAlignment = alignof(max_align_t);
+  return (size + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+// Bodies larger than this are freed rather than kept around for reuse.
+const size_t kMaxRecycledStringCapacity = 64 * 1024;
+const size_t kMaxRecycledStrings = 256;
+
+struct StringStash {
+  StringStash() : live(0), reused(0) {}
+
+  std::vector<std::string> strings;
+  size_t live;
+  uint64_t reused;
+};
+
+StringStash* GetStringStash() {
+  static thread_local StringStash stash;
+  return &stash;
+}
+
+}  // namespace
+
+GoQuicObjectPool::GoQuicObjectPool(size_t object_size)
+    : object_size_(AlignedSize(std::max(object_size, sizeof(FreeObject)))),
+      free_list_(nullptr),
+      live_(0),
+      free_(0),
+      allocations_(0) {}
+
+GoQuicObjectPool::~GoQuicObjectPool() {
+  DCHECK_EQ(0u, live_);
+}
+
+void GoQuicObjectPool::AddSlab() {
+  // new char[] is aligned for any fundamental type, and every object size is
+  // a multiple of that alignment.
+  std::unique_ptr<char[]> slab(new char[object_size_ * kObjectsPerSlab]);
+  for (size_t i = 0; i < kObjectsPerSlab; i++) {
+    FreeObject* object =
+        reinterpret_cast<FreeObject*>(slab.get() + i * object_size_);
+    object->next = free_list_;
+    free_list_ = object;
+  }
+  free_ += kObjectsPerSlab;
+  slabs_.push_back(std::move(slab));
+}
+
+void* GoQuicObjectPool::Allocate() {
+  if (free_list_ == nullptr) {
+    AddSlab();
+  }
+  FreeObject* object = free_list_;
+  free_list_ = object->next;
+  free_--;
+  live_++;
+  allocations_++;
+  return object;
+}
+
+void GoQuicObjectPool::Free(void* p) {
+  FreeObject* object = static_cast<FreeObject*>(p);
+  object->next = free_list_;
+  free_list_ = object;
+  free_++;
+  live_--;
+}
+
+void GoQuicObjectPool::GetStats(GoQuicPoolStat* stat) const {
+  stat->Live = live_;
+  stat->Free = free_;
+  stat->Allocations = allocations_;
+}
+
+// static
+void GoQuicStringPool::Acquire(std::string* str) {
+  DCHECK(str->empty());
+  StringStash* stash = GetStringStash();
+  stash->live++;
+  if (!stash->strings.empty()) {
+    str->swap(stash->strings.back());
+    stash->strings.pop_back();
+    stash->reused++;
+  }
+}
+
+// static
+void GoQuicStringPool::Release(std::string* str) {
+  StringStash* stash = GetStringStash();
+  stash->live--;
+  if (str->capacity() > kMaxRecycledStringCapacity ||
+      stash->strings.size() >= kMaxRecycledStrings) {
+    return;
+  }
+  str->clear();
+  stash->strings.push_back(std::move(*str));
+}
+
+// static
+void GoQuicStringPool::GetStats(GoQuicPoolStat* stat) {
+  StringStash* stash = GetStringStash();
+  stat->Live = stash->live;
+  stat->Free = stash->strings.size();
+  stat->Allocations = stash->reused;
+}
+
+}  // namespace net
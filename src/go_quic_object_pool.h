@@ -0,0 +1,101 @@
+#ifndef GO_QUIC_OBJECT_POOL_H_
+#define GO_QUIC_OBJECT_POOL_H_
+
+#include <stddef.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/macros.h"
+#include "go_structs.h"
+
+namespace net {
+
+// Slab allocator for objects of one size. Objects are carved out of slabs of
+// kObjectsPerSlab and recycled through a free list; slabs are kept until the
+// pool is destroyed, so a burst of connections leaves its memory ready for
+// the next one instead of fragmenting the heap.
+//
+// Not thread safe. Pools are thread_local (see GoQuicPooled), and every
+// dispatcher runs on its own locked OS thread, so each dispatcher gets its
+// own set of pools.
+class GoQuicObjectPool {
+ public:
+  explicit GoQuicObjectPool(size_t object_size);
+  ~GoQuicObjectPool();
+
+  void* Allocate();
+  void Free(void* p);
+
+  void GetStats(GoQuicPoolStat* stat) const;
+
+ private:
+  static const size_t kObjectsPerSlab = 64;
+
+  struct FreeObject {
+    FreeObject* next;
+  };
+
+  void AddSlab();
+
+  const size_t object_size_;
+  std::vector<std::unique_ptr<char[]>> slabs_;
+  FreeObject* free_list_;
+
+  size_t live_;
+  size_t free_;
+  uint64_t allocations_;
+
+  DISALLOW_COPY_AND_ASSIGN(GoQuicObjectPool);
+};
+
+// Mixin giving T class-specific operator new/delete backed by a per-thread
+// GoQuicObjectPool. Objects must be deleted on the thread that created them.
+// Subclasses of T which are larger than T fall back to the global heap.
+template <typename T>
+class GoQuicPooled {
+ public:
+  static void* operator new(size_t size) {
+    if (size != sizeof(T)) {
+      return ::operator new(size);
+    }
+    return pool()->Allocate();
+  }
+
+  static void operator delete(void* p, size_t size) {
+    if (p == nullptr) {
+      return;
+    }
+    if (size != sizeof(T)) {
+      ::operator delete(p);
+      return;
+    }
+    pool()->Free(p);
+  }
+
+  static void GetPoolStats(GoQuicPoolStat* stat) { pool()->GetStats(stat); }
+
+ private:
+  static GoQuicObjectPool* pool() {
+    static thread_local GoQuicObjectPool pool(sizeof(T));
+    return &pool;
+  }
+};
+
+// Per-thread stash of cleared std::strings whose capacity is reused by the
+// next stream that needs a body buffer.
+class GoQuicStringPool {
+ public:
+  // Moves a recycled buffer, if any, into |str|, which should be empty.
+  static void Acquire(std::string* str);
+  // Clears |str| and keeps its storage for a later Acquire(), unless it is
+  // too large to be worth keeping or the stash is full.
+  static void Release(std::string* str);
+
+  static void GetStats(GoQuicPoolStat* stat);
+};
+
+}  // namespace net
+
+#endif  // GO_QUIC_OBJECT_POOL_H_
@@ -4,18 +4,17 @@
 
 #include "go_quic_per_connection_packet_writer.h"
 
-#include "base/bind.h"
-#include "go_quic_server_packet_writer.h"
-
 namespace net {
 
 GoQuicPerConnectionPacketWriter::GoQuicPerConnectionPacketWriter(
     GoQuicServerPacketWriter* shared_writer)
     : shared_writer_(shared_writer),
       connection_(nullptr),
-      weak_factory_(this) {}
+      id_(shared_writer->RegisterConnectionWriter(this)) {}
 
-GoQuicPerConnectionPacketWriter::~GoQuicPerConnectionPacketWriter() {}
+GoQuicPerConnectionPacketWriter::~GoQuicPerConnectionPacketWriter() {
+  shared_writer_->UnregisterConnectionWriter(id_);
+}
 
 QuicPacketWriter* GoQuicPerConnectionPacketWriter::shared_writer() const {
   return shared_writer_;
@@ -27,10 +26,8 @@ WriteResult GoQuicPerConnectionPacketWriter::WritePacket(
     const IPAddress& self_address,
     const IPEndPoint& peer_address,
     PerPacketOptions* options) {
-  return shared_writer_->WritePacketWithCallback(
-      buffer, buf_len, self_address, peer_address, options,
-      base::Bind(&GoQuicPerConnectionPacketWriter::OnWriteComplete,
-                 weak_factory_.GetWeakPtr()));
+  return shared_writer_->WritePacketForConnection(
+      id_, buffer, buf_len, self_address, peer_address, options);
 }
 
 bool GoQuicPerConnectionPacketWriter::IsWriteBlockedDataBuffered() const {
@@ -5,21 +5,23 @@
 #ifndef GO_QUIC_PER_CONNECTION_PACKET_WRITER_H_
 #define GO_QUIC_PER_CONNECTION_PACKET_WRITER_H_
 
-#include "base/memory/weak_ptr.h"
 #include "net/base/ip_address.h"
 #include "net/quic/core/quic_connection.h"
 #include "net/quic/core/quic_packet_writer.h"
+#include "go_quic_object_pool.h"
+#include "go_quic_server_packet_writer.h"
 
 namespace net {
 
-class GoQuicServerPacketWriter;
-
 // A connection-specific packet writer that notifies its connection when its
 // writes to the shared GoQuicServerPacketWriter complete.
 // This class is necessary because multiple connections can share the same
 // GoQuicServerPacketWriter, so it has no way to know which connection to
-// notify.
-class GoQuicPerConnectionPacketWriter : public QuicPacketWriter {
+// notify. Each writer registers with the shared writer once and is then
+// identified by a small ID, so sending a packet allocates nothing.
+class GoQuicPerConnectionPacketWriter
+    : public QuicPacketWriter,
+      public GoQuicPooled<GoQuicPerConnectionPacketWriter> {
  public:
   // Does not take ownership of |shared_writer| or |connection|.
   GoQuicPerConnectionPacketWriter(GoQuicServerPacketWriter* shared_writer);
@@ -41,13 +43,15 @@ class GoQuicPerConnectionPacketWriter : public QuicPacketWriter {
   void SetWritable() override;
   QuicByteCount GetMaxPacketSize(const IPEndPoint& peer_address) const override;
 
- private:
+  // Called by |shared_writer_| when a write of ours that was blocked
+  // completes.
   void OnWriteComplete(WriteResult result);
 
+ private:
   GoQuicServerPacketWriter* shared_writer_;  // Not owned.
   QuicConnection* connection_;               // Not owned.
 
-  base::WeakPtrFactory<GoQuicPerConnectionPacketWriter> weak_factory_;
+  GoQuicServerPacketWriter::ConnectionWriterId id_;
 
   DISALLOW_COPY_AND_ASSIGN(GoQuicPerConnectionPacketWriter);
 };
@@ -0,0 +1,95 @@
+#include "go_quic_prefix_rate_limiter.h"
+
+#include <algorithm>
+
+#include "base/logging.h"
+
+namespace net {
+
+namespace {
+
+// Mask of the top |prefix_length| of the low |width| bits.
+uint64_t PrefixMask(int prefix_length, int width) {
+  prefix_length = std::min(std::max(prefix_length, 0), width);
+  if (prefix_length == 0) {
+    return 0;
+  }
+  return ((1ull << prefix_length) - 1) << (width - prefix_length);
+}
+
+}  // namespace
+
+GoQuicPrefixRateLimiter::GoQuicPrefixRateLimiter(int ipv4_prefix_length,
+                                                 int ipv6_prefix_length,
+                                                 double rate,
+                                                 double burst,
+                                                 size_t num_buckets,
+                                                 uint64_t seed)
+    : ipv4_mask_(PrefixMask(ipv4_prefix_length, 32)),
+      ipv6_mask_(PrefixMask(ipv6_prefix_length, 56)),
+      rate_(rate),
+      burst_(std::max(burst, 1.0)),
+      seed_(seed) {
+  size_t num_sets = 1;
+  while (num_sets * 2 < num_buckets) {
+    num_sets *= 2;
+  }
+  Bucket empty = {0, QuicTime::Zero(), 0};
+  buckets_.assign(num_sets * 2, empty);
+  set_mask_ = num_sets - 1;
+}
+
+GoQuicPrefixRateLimiter::~GoQuicPrefixRateLimiter() {}
+
+uint64_t GoQuicPrefixRateLimiter::PrefixKey(const IPAddress& address) const {
+  // The family is tagged in the top bits, so keys are never zero and IPv4
+  // and IPv6 prefixes never share a bucket.
+  const std::vector<uint8_t>& bytes = address.bytes();
+  if (address.IsIPv4()) {
+    DCHECK_EQ(4u, bytes.size());
+    uint64_t ip = (static_cast<uint64_t>(bytes[0]) << 24) |
+                  (static_cast<uint64_t>(bytes[1]) << 16) |
+                  (static_cast<uint64_t>(bytes[2]) << 8) | bytes[3];
+    return (1ull << 63) | (ip & ipv4_mask_);
+  }
+  DCHECK_EQ(16u, bytes.size());
+  uint64_t ip = 0;
+  for (int i = 0; i < 7; i++) {
+    ip = (ip << 8) | bytes[i];
+  }
+  return (1ull << 62) | (ip & ipv6_mask_);
+}
+
+bool GoQuicPrefixRateLimiter::Allow(const IPAddress& address, QuicTime now) {
+  const uint64_t key = PrefixKey(address);
+  uint64_t hash = (key ^ seed_) * 0x9E3779B97F4A7C15ull;
+  hash ^= hash >> 32;
+  Bucket* set = &buckets_[(static_cast<size_t>(hash) & set_mask_) * 2];
+
+  Bucket* bucket;
+  if (set[0].key == key) {
+    bucket = &set[0];
+  } else if (set[1].key == key) {
+    bucket = &set[1];
+  } else {
+    // Evict the slot used least recently; unused slots have the oldest time.
+    bucket = set[0].last_update <= set[1].last_update ? &set[0] : &set[1];
+    bucket->key = key;
+    bucket->tokens = burst_;
+    bucket->last_update = now;
+  }
+
+  if (now > bucket->last_update) {
+    double elapsed = (now - bucket->last_update).ToMicroseconds() * 1e-6;
+    bucket->tokens = std::min(burst_, bucket->tokens + elapsed * rate_);
+  }
+  bucket->last_update = now;
+
+  if (bucket->tokens < 1) {
+    return false;
+  }
+  bucket->tokens -= 1;
+  return true;
+}
+
+}  // namespace net
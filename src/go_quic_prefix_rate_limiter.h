@@ -0,0 +1,64 @@
+#ifndef GO_QUIC_PREFIX_RATE_LIMITER_H_
+#define GO_QUIC_PREFIX_RATE_LIMITER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "base/macros.h"
+#include "net/base/ip_address.h"
+#include "net/quic/core/quic_time.h"
+
+namespace net {
+
+// Token buckets keyed by source address prefix, so that a client cannot
+// escape its limit by cycling through the addresses of its network.
+//
+// The buckets live in a fixed size, two-way set associative table. When both
+// slots of a set are taken by other prefixes, the one used least recently is
+// evicted and starts over with a full bucket, so collisions only ever err on
+// the side of letting traffic through.
+class GoQuicPrefixRateLimiter {
+ public:
+  // Addresses are grouped by their first |ipv4_prefix_length| (at most 32)
+  // or |ipv6_prefix_length| (at most 56) bits. Each bucket gains |rate|
+  // tokens per second, up to |burst|. |num_buckets| is rounded up to a power
+  // of two. |seed| randomizes the hash, so that clients cannot choose
+  // addresses which share a set.
+  GoQuicPrefixRateLimiter(int ipv4_prefix_length,
+                          int ipv6_prefix_length,
+                          double rate,
+                          double burst,
+                          size_t num_buckets,
+                          uint64_t seed);
+  ~GoQuicPrefixRateLimiter();
+
+  // Takes a token from the bucket of |address|'s prefix. Returns false if the
+  // bucket is empty.
+  bool Allow(const IPAddress& address, QuicTime now);
+
+ private:
+  struct Bucket {
+    uint64_t key;  // Zero if the slot is unused
+    QuicTime last_update;
+    double tokens;
+  };
+
+  uint64_t PrefixKey(const IPAddress& address) const;
+
+  const uint64_t ipv4_mask_;
+  const uint64_t ipv6_mask_;
+  const double rate_;
+  const double burst_;
+  const uint64_t seed_;
+
+  std::vector<Bucket> buckets_;  // Sets of two adjacent slots
+  size_t set_mask_;
+
+  DISALLOW_COPY_AND_ASSIGN(GoQuicPrefixRateLimiter);
+};
+
+}  // namespace net
+
+#endif  // GO_QUIC_PREFIX_RATE_LIMITER_H_
@@ -4,7 +4,8 @@
 
 #include "go_quic_server_packet_writer.h"
 
-#include "base/callback_helpers.h"
+#include <string.h>
+
 #include "base/location.h"
 #include "base/logging.h"
 #include "base/metrics/sparse_histogram.h"
@@ -12,35 +13,64 @@
 #include "net/base/net_errors.h"
 
 #include "go_functions.h"
+#include "go_quic_per_connection_packet_writer.h"
 
 namespace net {
 
 GoQuicServerPacketWriter::GoQuicServerPacketWriter(
     GoPtr go_writer,
-    QuicBlockedWriterInterface* blocked_writer)
+    QuicBlockedWriterInterface* blocked_writer,
+    GoQuicDispatcherMetrics* metrics)
     : go_writer_(go_writer),
       blocked_writer_(blocked_writer),
-      write_blocked_(false),
-      weak_factory_(this) {}
+      metrics_(metrics),
+      blocked_connection_writer_(0),
+      write_blocked_(false) {
+  send_buffer_.reserve(kMaxBufferedPackets * kMaxPacketSize);
+  send_descs_.reserve(kMaxBufferedPackets);
+}
 
 GoQuicServerPacketWriter::~GoQuicServerPacketWriter() {
+  Flush();
   ReleaseServerWriter_C(go_writer_);
 	// TODO(hodduc): release go_writer
 }
 
-WriteResult GoQuicServerPacketWriter::WritePacketWithCallback(
+GoQuicServerPacketWriter::ConnectionWriterId
+GoQuicServerPacketWriter::RegisterConnectionWriter(
+    GoQuicPerConnectionPacketWriter* writer) {
+  if (free_connection_writer_ids_.empty()) {
+    connection_writers_.push_back(writer);
+    return static_cast<ConnectionWriterId>(connection_writers_.size());
+  }
+  ConnectionWriterId id = free_connection_writer_ids_.back();
+  free_connection_writer_ids_.pop_back();
+  connection_writers_[id - 1] = writer;
+  return id;
+}
+
+void GoQuicServerPacketWriter::UnregisterConnectionWriter(
+    ConnectionWriterId id) {
+  DCHECK(id > 0 && id <= connection_writers_.size());
+  connection_writers_[id - 1] = nullptr;
+  free_connection_writer_ids_.push_back(id);
+  if (blocked_connection_writer_ == id) {
+    blocked_connection_writer_ = 0;
+  }
+}
+
+WriteResult GoQuicServerPacketWriter::WritePacketForConnection(
+    ConnectionWriterId id,
     const char* buffer,
     size_t buf_len,
     const IPAddress& self_address,
     const IPEndPoint& peer_address,
-    PerPacketOptions* options,
-    WriteCallback callback) {
-  DCHECK(callback_.is_null());
-  callback_ = callback;
+    PerPacketOptions* options) {
+  DCHECK_EQ(0u, blocked_connection_writer_);
   WriteResult result =
       WritePacket(buffer, buf_len, self_address, peer_address, options);
-  if (result.status != WRITE_STATUS_BLOCKED) {
-    callback_.Reset();
+  if (result.status == WRITE_STATUS_BLOCKED) {
+    blocked_connection_writer_ = id;
   }
   return result;
 }
@@ -48,15 +78,19 @@ WriteResult GoQuicServerPacketWriter::WritePacketWithCallback(
 void GoQuicServerPacketWriter::OnWriteComplete(int rv) {
   DCHECK_NE(rv, ERR_IO_PENDING);
   write_blocked_ = false;
-  WriteResult result(rv < 0 ? WRITE_STATUS_ERROR : WRITE_STATUS_OK, rv);
-  if (!callback_.is_null()) {
-    base::ResetAndReturn(&callback_).Run(result);
+  if (blocked_connection_writer_ != 0) {
+    GoQuicPerConnectionPacketWriter* writer =
+        connection_writers_[blocked_connection_writer_ - 1];
+    blocked_connection_writer_ = 0;
+    writer->OnWriteComplete(
+        WriteResult(rv < 0 ? WRITE_STATUS_ERROR : WRITE_STATUS_OK, rv));
   }
   blocked_writer_->OnCanWrite();
 }
 
 bool GoQuicServerPacketWriter::IsWriteBlockedDataBuffered() const {
-  // UDPServerSocket::SendTo buffers the data until the Write is permitted.
+  // A packet whose write reported WRITE_STATUS_BLOCKED has already been
+  // queued, and is sent once Go's egress queue drains.
   return true;
 }
 
@@ -78,16 +112,30 @@ WriteResult GoQuicServerPacketWriter::WritePacket(
   //      new StringIOBuffer(std::string(buffer, buf_len)));
   DCHECK(!IsWriteBlocked());
   int rv;
+  bool blocked = false;
   if (buf_len <= static_cast<size_t>(std::numeric_limits<int>::max())) {
-    auto peer_ip = peer_address.address().bytes();
+    if (send_descs_.size() == kMaxBufferedPackets ||
+        send_buffer_.size() + buf_len > send_buffer_.capacity()) {
+      blocked = !Flush();
+    }
 
-    WriteToUDP_C(go_writer_, reinterpret_cast<char*>(peer_ip.data()), peer_ip.size(),
-                 peer_address.port(), (void*)buffer, buf_len);
+    const std::vector<uint8_t>& peer_ip = peer_address.address().bytes();
+    GoPacketDesc desc = {};
+    memcpy(desc.Peer_ip, peer_ip.data(), peer_ip.size());
+    desc.Peer_ip_len = peer_ip.size();
+    desc.Peer_port = peer_address.port();
+    desc.Offset = send_buffer_.size();
+    desc.Length = buf_len;
+    desc.Timestamp = 0;
+
+    send_buffer_.insert(send_buffer_.end(), buffer, buffer + buf_len);
+    send_descs_.push_back(desc);
+    metrics_->Increment(GoQuicDispatcherMetrics::kPacketsSent);
     rv = buf_len;
   } else {
     rv = ERR_MSG_TOO_BIG;
   }
-  WriteStatus status = WRITE_STATUS_OK;
+  WriteStatus status = blocked ? WRITE_STATUS_BLOCKED : WRITE_STATUS_OK;
   if (rv < 0) {
     if (rv != ERR_IO_PENDING) {
       UMA_HISTOGRAM_SPARSE_SLOWLY("Net.QuicSession.WriteError", -rv);
@@ -100,6 +148,22 @@ WriteResult GoQuicServerPacketWriter::WritePacket(
   return WriteResult(status, rv);
 }
 
+bool GoQuicServerPacketWriter::Flush() {
+  if (send_descs_.empty()) {
+    return !write_blocked_;
+  }
+
+  if (!WriteToUDPBatch_C(go_writer_, send_descs_.data(), send_descs_.size(),
+                         send_buffer_.data(), send_buffer_.size()) &&
+      !write_blocked_) {
+    write_blocked_ = true;
+    metrics_->Increment(GoQuicDispatcherMetrics::kWriteBlocks);
+  }
+  send_descs_.clear();
+  send_buffer_.clear();
+  return !write_blocked_;
+}
+
 QuicByteCount GoQuicServerPacketWriter::GetMaxPacketSize(
     const IPEndPoint& peer_address) const {
   return kMaxPacketSize;
@@ -5,35 +5,47 @@
 #ifndef GO_QUIC_SERVER_PACKET_WRITER_H_
 #define GO_QUIC_SERVER_PACKET_WRITER_H_
 
-#include "base/memory/weak_ptr.h"
-#include "base/callback.h"
+#include <vector>
+
 #include "net/base/ip_address.h"
 #include "net/base/ip_endpoint.h"
 #include "net/quic/core/quic_connection.h"
 #include "net/quic/core/quic_packet_writer.h"
 #include "net/quic/core/quic_protocol.h"
+#include "go_quic_dispatcher_metrics.h"
 #include "go_structs.h"
 
 namespace net {
 
+class GoQuicPerConnectionPacketWriter;
 class QuicBlockedWriterInterface;
 struct WriteResult;
 
 class GoQuicServerPacketWriter : public QuicPacketWriter {
  public:
-  typedef base::Callback<void(WriteResult)> WriteCallback;
+  // Identifies a registered GoQuicPerConnectionPacketWriter. 0 is never a
+  // valid ID.
+  typedef uint32_t ConnectionWriterId;
 
   GoQuicServerPacketWriter(GoPtr go_writer,
-                           QuicBlockedWriterInterface* blocked_writer);
+                           QuicBlockedWriterInterface* blocked_writer,
+                           GoQuicDispatcherMetrics* metrics);
   ~GoQuicServerPacketWriter() override;
 
-  // Wraps WritePacket, and ensures that |callback| is run on successful write.
-  WriteResult WritePacketWithCallback(const char* buffer,
-                                      size_t buf_len,
-                                      const IPAddress& self_address,
-                                      const IPEndPoint& peer_address,
-                                      PerPacketOptions* options,
-                                      WriteCallback callback);
+  // Per-connection writers register once, when they are created, so that
+  // writing a packet on their behalf only needs their ID.
+  ConnectionWriterId RegisterConnectionWriter(
+      GoQuicPerConnectionPacketWriter* writer);
+  void UnregisterConnectionWriter(ConnectionWriterId id);
+
+  // Like WritePacket, but if the write is blocked the writer registered as
+  // |id| is notified through OnWriteComplete() when it completes.
+  WriteResult WritePacketForConnection(ConnectionWriterId id,
+                                       const char* buffer,
+                                       size_t buf_len,
+                                       const IPAddress& self_address,
+                                       const IPEndPoint& peer_address,
+                                       PerPacketOptions* options);
 
   WriteResult WritePacket(const char* buffer,
                           size_t buf_len,
@@ -43,6 +55,12 @@ class GoQuicServerPacketWriter : public QuicPacketWriter {
 
   void OnWriteComplete(int rv);
 
+  // Passes all packets buffered since the last flush to Go with a single
+  // WriteToUDPBatch_C call. Returns false, and marks the writer blocked, if
+  // Go's egress queue went above its high watermark; Go calls back through
+  // OnWriteComplete() once it has drained.
+  bool Flush();
+
   // QuicPacketWriter implementation:
   bool IsWriteBlockedDataBuffered() const override;
   bool IsWriteBlocked() const override;
@@ -50,18 +68,33 @@ class GoQuicServerPacketWriter : public QuicPacketWriter {
   QuicByteCount GetMaxPacketSize(const IPEndPoint& peer_address) const override;
 
  private:
+  // Maximum number of packets buffered before an implicit flush.
+  static const size_t kMaxBufferedPackets = 64;
+
   GoPtr go_writer_;
 
+  // Packets written since the last Flush(), laid out back to back in
+  // |send_buffer_| and described by |send_descs_|.
+  std::vector<char> send_buffer_;
+  std::vector<GoPacketDesc> send_descs_;
+
   // To be notified after every successful asynchronous write.
   QuicBlockedWriterInterface* blocked_writer_;
 
-  // To call once the write completes.
-  WriteCallback callback_;
+  GoQuicDispatcherMetrics* metrics_;  // Not owned.
 
-  // Whether a write is currently in flight.
-  bool write_blocked_;
+  // Registered per-connection writers, indexed by ID - 1. Slots of
+  // unregistered writers are null and their IDs are reused.
+  std::vector<GoQuicPerConnectionPacketWriter*> connection_writers_;
+  std::vector<ConnectionWriterId> free_connection_writer_ids_;
+
+  // Writer to notify once the blocked write completes, or 0.
+  ConnectionWriterId blocked_connection_writer_;
 
-  base::WeakPtrFactory<GoQuicServerPacketWriter> weak_factory_;
+  // Whether Go's egress queue is backed up. Packets are still accepted (and
+  // handed to Go on the next flush) while blocked, but connections are told
+  // to stop writing until OnWriteComplete() is called.
+  bool write_blocked_;
 
   DISALLOW_COPY_AND_ASSIGN(GoQuicServerPacketWriter);
 };
@@ -7,15 +7,16 @@
 namespace net {
 
 GoQuicSimpleCryptoServerStreamHelper::GoQuicSimpleCryptoServerStreamHelper(
-    QuicRandom* random)
-    : random_(random) {}
+    QuicRandom* random,
+    const GoQuicDispatcherConfig& config)
+    : connection_id_generator_(random, config) {}
 
 GoQuicSimpleCryptoServerStreamHelper::~GoQuicSimpleCryptoServerStreamHelper() {}
 
 QuicConnectionId
     GoQuicSimpleCryptoServerStreamHelper::GenerateConnectionIdForReject(
         QuicConnectionId /*connection_id*/) const {
-  return random_->RandUint64();
+  return connection_id_generator_.GenerateConnectionId();
 }
 
 bool GoQuicSimpleCryptoServerStreamHelper::CanAcceptClientHello(
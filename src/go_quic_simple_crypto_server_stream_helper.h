@@ -4,14 +4,17 @@
 #include "net/quic/core/crypto/quic_random.h"
 #include "net/quic/core/quic_crypto_server_stream.h"
 
+#include "go_quic_connection_id_generator.h"
+
 namespace net {
 
-// Simple helper for server sessions which generates a new random
-// connection ID for stateless rejects.
+// Simple helper for server sessions which generates a new connection ID for
+// stateless rejects. The ID routes back to the issuing dispatcher.
 class GoQuicSimpleCryptoServerStreamHelper
     : public QuicCryptoServerStream::Helper {
  public:
-  explicit GoQuicSimpleCryptoServerStreamHelper(QuicRandom* random);
+  GoQuicSimpleCryptoServerStreamHelper(QuicRandom* random,
+                                       const GoQuicDispatcherConfig& config);
 
   ~GoQuicSimpleCryptoServerStreamHelper() override;
 
@@ -23,7 +26,7 @@ class GoQuicSimpleCryptoServerStreamHelper
                             std::string* error_details) const override;
 
  private:
-  QuicRandom* random_;  // Unowned.
+  GoQuicConnectionIdGenerator connection_id_generator_;
 };
 
 }  // namespace net
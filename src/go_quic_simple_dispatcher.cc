@@ -3,11 +3,24 @@
 // found in the LICENSE file.
 
 #include "go_quic_simple_dispatcher.h"
+#include "go_quic_object_pool.h"
+#include "go_quic_per_connection_packet_writer.h"
 #include "go_quic_simple_server_session.h"
 #include "go_functions.h"
 
 namespace net {
 
+namespace {
+
+// QuicConnection allocated from the dispatcher's connection pool.
+class GoQuicPooledConnection : public QuicConnection,
+                               public GoQuicPooled<GoQuicPooledConnection> {
+ public:
+  using QuicConnection::QuicConnection;
+};
+
+}  // namespace
+
 GoQuicSimpleDispatcher::GoQuicSimpleDispatcher(
     const QuicConfig& config,
     const QuicCryptoServerConfig* crypto_config,
@@ -26,11 +39,20 @@ GoQuicSimpleDispatcher::GoQuicSimpleDispatcher(
 
 GoQuicSimpleDispatcher::~GoQuicSimpleDispatcher() {}
 
+// static
+void GoQuicSimpleDispatcher::GetPoolStats(GoQuicPoolStats* stats) {
+  GoQuicPooled<GoQuicPooledConnection>::GetPoolStats(&stats->Connections);
+  GoQuicPooled<GoQuicPerConnectionPacketWriter>::GetPoolStats(&stats->Writers);
+  GoQuicPooled<GoQuicSimpleServerSession>::GetPoolStats(&stats->Sessions);
+  GoQuicPooled<GoQuicSimpleServerStream>::GetPoolStats(&stats->Streams);
+  GoQuicStringPool::GetStats(&stats->Bodies);
+}
+
 QuicServerSessionBase* GoQuicSimpleDispatcher::CreateQuicSession(
     QuicConnectionId connection_id,
     const IPEndPoint& client_address) {
   // The QuicServerSessionBase takes ownership of |connection| below.
-  QuicConnection* connection = new QuicConnection(
+  QuicConnection* connection = new GoQuicPooledConnection(
       connection_id, client_address, helper(), alarm_factory(),
       CreatePerConnectionWriter(),
       /* owns_writer= */ true, Perspective::IS_SERVER, GetSupportedVersions());
@@ -23,6 +23,10 @@ class GoQuicSimpleDispatcher : public GoQuicDispatcher {
 
   ~GoQuicSimpleDispatcher() override;
 
+  // Occupancy of the object pools of the calling thread, i.e. of the
+  // dispatcher running on it.
+  static void GetPoolStats(GoQuicPoolStats* stats);
+
  protected:
   QuicServerSessionBase* CreateQuicSession(
       QuicConnectionId connection_id,
@@ -19,6 +19,7 @@
 #include "net/quic/core/quic_server_session_base.h"
 #include "net/quic/core/quic_spdy_session.h"
 
+#include "go_quic_object_pool.h"
 #include "go_quic_simple_server_stream.h"
 
 namespace net {
@@ -29,7 +30,9 @@ class QuicConnection;
 class QuicCryptoServerConfig;
 class ReliableQuicStream;
 
-class GoQuicSimpleServerSession : public QuicServerSessionBase {
+class GoQuicSimpleServerSession
+    : public QuicServerSessionBase,
+      public GoQuicPooled<GoQuicSimpleServerSession> {
  public:
   // Takes ownership of |connection|.
   GoQuicSimpleServerSession(const QuicConfig& config,
@@ -6,14 +6,16 @@
 
 namespace net {
 
-GoQuicSimpleServerSessionHelper::GoQuicSimpleServerSessionHelper(QuicRandom* random)
-    : random_(random) {}
+GoQuicSimpleServerSessionHelper::GoQuicSimpleServerSessionHelper(
+    QuicRandom* random,
+    const GoQuicDispatcherConfig& config)
+    : connection_id_generator_(random, config) {}
 
 GoQuicSimpleServerSessionHelper::~GoQuicSimpleServerSessionHelper() {}
 
 QuicConnectionId GoQuicSimpleServerSessionHelper::GenerateConnectionIdForReject(
     QuicConnectionId /*connection_id*/) const {
-  return random_->RandUint64();
+  return connection_id_generator_.GenerateConnectionId();
 }
 
 bool GoQuicSimpleServerSessionHelper::CanAcceptClientHello(
@@ -4,13 +4,16 @@
 #include "net/quic/core/crypto/quic_random.h"
 #include "net/quic/core/quic_server_session_base.h"
 
+#include "go_quic_connection_id_generator.h"
+
 namespace net {
 
-// Simple helper for server sessions which generates a new random
-// connection ID for stateless rejects.
+// Simple helper for server sessions which generates a new connection ID for
+// stateless rejects. The ID routes back to the issuing dispatcher.
 class GoQuicSimpleServerSessionHelper : public QuicCryptoServerStream::Helper {
  public:
-  explicit GoQuicSimpleServerSessionHelper(QuicRandom* random);
+  GoQuicSimpleServerSessionHelper(QuicRandom* random,
+                                  const GoQuicDispatcherConfig& config);
 
   ~GoQuicSimpleServerSessionHelper() override;
 
@@ -22,7 +25,7 @@ class GoQuicSimpleServerSessionHelper : public QuicCryptoServerStream::Helper {
                             std::string* error_details) const override;
 
  private:
-  QuicRandom* random_;  // Unowned.
+  GoQuicConnectionIdGenerator connection_id_generator_;
 };
 
 }  // namespace net
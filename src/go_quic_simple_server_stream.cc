@@ -2,6 +2,10 @@
 #include "go_functions.h"
 #include "go_utils.h"
 
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
 #include <utility>
 
 #include "net/quic/core/quic_session.h"
@@ -14,9 +18,20 @@ namespace net {
 
 GoQuicSimpleServerStream::GoQuicSimpleServerStream(QuicStreamId id,
                                                    QuicSpdySession* session)
-    : QuicSpdyStream(id, session), content_length_(-1) {}
+    : QuicSpdyStream(id, session),
+      content_length_(-1),
+      streaming_(false),
+      body_pending_(0),
+      body_forwarded_(0),
+      has_pending_trailers_(false) {
+  GoQuicStringPool::Acquire(&body_);
+}
 
 GoQuicSimpleServerStream::~GoQuicSimpleServerStream() {
+  GoQuicStringPool::Release(&body_);
+  for (const BodyBuffer& buffer : body_buffers_) {
+    free(buffer.data);
+  }
   UnregisterQuicServerStreamFromSession_C(go_quic_simple_server_stream_);
 }
 
@@ -25,6 +40,10 @@ void GoQuicSimpleServerStream::SetGoQuicSimpleServerStream(
   go_quic_simple_server_stream_ = go_quic_simple_server_stream;
 }
 
+void GoQuicSimpleServerStream::EnableBodyStreaming() {
+  streaming_ = true;
+}
+
 void GoQuicSimpleServerStream::OnInitialHeadersComplete(bool fin,
                                                         size_t frame_len) {
   QuicSpdyStream::OnInitialHeadersComplete(fin, frame_len);
@@ -33,12 +52,19 @@ void GoQuicSimpleServerStream::OnInitialHeadersComplete(bool fin,
                                &content_length_, &request_headers_)) {
     DVLOG(1) << "Invalid headers";
     SendErrorResponse();
+    MarkHeadersConsumed(decompressed_headers().length());
+    return;
+  }
+  if (request_headers_.empty()) {
+    DVLOG(1) << "Request headers empty.";
+    SendErrorResponse();
+    MarkHeadersConsumed(decompressed_headers().length());
+    return;
   }
 
   auto peer_address = spdy_session()->connection()->peer_address().ToString();
-  auto hdr = CreateGoSpdyHeader(request_headers_);
+  auto hdr = PackGoRequestHeaders(request_headers_);
   GoQuicSimpleServerStreamOnInitialHeadersComplete_C(go_quic_simple_server_stream_, hdr, peer_address.data(), peer_address.length());
-  DeleteGoSpdyHeader(hdr);
 
   MarkHeadersConsumed(decompressed_headers().length());
 }
@@ -52,12 +78,19 @@ void GoQuicSimpleServerStream::OnInitialHeadersComplete(
                                          &request_headers_)) {
     DVLOG(1) << "Invalid headers";
     SendErrorResponse();
+    ConsumeHeaderList();
+    return;
+  }
+  if (request_headers_.empty()) {
+    DVLOG(1) << "Request headers empty.";
+    SendErrorResponse();
+    ConsumeHeaderList();
+    return;
   }
 
   auto peer_address = spdy_session()->connection()->peer_address().ToString();
-  auto hdr = CreateGoSpdyHeader(request_headers_);
+  auto hdr = PackGoRequestHeaders(request_headers_);
   GoQuicSimpleServerStreamOnInitialHeadersComplete_C(go_quic_simple_server_stream_, hdr, peer_address.data(), peer_address.length());
-  DeleteGoSpdyHeader(hdr);
 
   ConsumeHeaderList();
 }
@@ -77,6 +110,11 @@ void GoQuicSimpleServerStream::OnTrailingHeadersComplete(
 }
 
 void GoQuicSimpleServerStream::OnDataAvailable() {
+  if (streaming_) {
+    ForwardBody();
+    return;
+  }
+
   while (HasBytesToRead()) {
     struct iovec iov;
     if (GetReadableRegions(&iov, 1) == 0) {
@@ -127,6 +165,85 @@ void GoQuicSimpleServerStream::OnDataAvailable() {
                                             sequencer()->IsClosed());
 }
 
+void GoQuicSimpleServerStream::ForwardBody() {
+  if (reading_stopped() || read_side_closed()) {
+    return;
+  }
+
+  // The sequencer does not notify us about data arriving behind bytes we
+  // have not consumed yet, so this is also run after every MarkBodyConsumed().
+  // Only the first kMaxRegions blocks are looked at, which also bounds how
+  // much unconsumed data Go has to buffer; the rest becomes visible as the
+  // handler consumes.
+  const int kMaxRegions = 16;
+  struct iovec iov[kMaxRegions];
+  int num_regions = HasBytesToRead() ? GetReadableRegions(iov, kMaxRegions) : 0;
+
+  // Skip what has already been forwarded.
+  size_t skip = body_pending_;
+  for (int i = 0; i < num_regions; i++) {
+    if (skip >= iov[i].iov_len) {
+      skip -= iov[i].iov_len;
+      continue;
+    }
+    const char* data = static_cast<char*>(iov[i].iov_base) + skip;
+    size_t len = iov[i].iov_len - skip;
+    skip = 0;
+
+    DVLOG(1) << "Forwarded " << len << " bytes for stream " << id();
+    body_pending_ += len;
+    body_forwarded_ += len;
+    if (content_length_ >= 0 &&
+        body_forwarded_ > static_cast<uint64_t>(content_length_)) {
+      DVLOG(1) << "Body size (" << body_forwarded_ << ") > content length ("
+               << content_length_ << ").";
+      // The handler may already be responding, so a 500 response is no
+      // longer an option.
+      Reset(QUIC_BAD_APPLICATION_PAYLOAD);
+      return;
+    }
+    GoQuicSimpleServerStreamOnDataAvailable_C(go_quic_simple_server_stream_,
+                                              data, len, 0);
+  }
+
+  if (body_pending_ > 0 || !sequencer()->IsClosed()) {
+    return;
+  }
+
+  // Everything up to the FIN has been read by the handler.
+  OnFinRead();
+
+  if (content_length_ > 0 &&
+      static_cast<uint64_t>(content_length_) != body_forwarded_) {
+    DVLOG(1) << "Content length (" << content_length_ << ") != body size ("
+             << body_forwarded_ << ").";
+    Reset(QUIC_BAD_APPLICATION_PAYLOAD);
+    return;
+  }
+
+  GoQuicSimpleServerStreamOnDataAvailable_C(go_quic_simple_server_stream_,
+                                            nullptr, 0, 1);
+}
+
+void GoQuicSimpleServerStream::MarkBodyConsumed(size_t num_bytes) {
+  if (!streaming_ || reading_stopped()) {
+    return;
+  }
+  DCHECK_LE(num_bytes, body_pending_);
+  num_bytes = std::min(num_bytes, body_pending_);
+  body_pending_ -= num_bytes;
+  MarkConsumed(num_bytes);
+  ForwardBody();
+}
+
+void GoQuicSimpleServerStream::StopReadingBody() {
+  if (!reading_stopped()) {
+    // Discards everything buffered, including what Go has not consumed.
+    StopReading();
+  }
+  body_pending_ = 0;
+}
+
 void GoQuicSimpleServerStream::SendErrorResponse() {
   DVLOG(1) << "Sending error response for stream " << id();
   SpdyHeaderBlock headers;
@@ -142,12 +259,83 @@ size_t GoQuicSimpleServerStream::WriteHeaders(
     bool fin,
     QuicAckListenerInterface* ack_notifier_delegate) {
 
-  if (!reading_stopped()) {
+  // A streaming handler may respond before it has read the whole request.
+  if (!streaming_ && !reading_stopped()) {
     StopReading();
   }
   return QuicSpdyStream::WriteHeaders(std::move(header_block), fin, ack_notifier_delegate);
 }
 
+size_t GoQuicSimpleServerStream::WriteTrailers(
+    SpdyHeaderBlock trailer_block,
+    QuicAckListenerInterface* ack_notifier_delegate) {
+  if (!body_buffers_.empty()) {
+    DCHECK(ack_notifier_delegate == nullptr);
+    has_pending_trailers_ = true;
+    pending_trailers_ = std::move(trailer_block);
+    return 0;
+  }
+  return QuicSpdyStream::WriteTrailers(std::move(trailer_block),
+                                       ack_notifier_delegate);
+}
+
+void GoQuicSimpleServerStream::OnCanWrite() {
+  QuicSpdyStream::OnCanWrite();
+  WriteBodyBuffers();
+}
+
+void GoQuicSimpleServerStream::WriteBodyBuffer(char* data,
+                                               size_t len,
+                                               bool fin) {
+  if (write_side_closed() || fin_buffered()) {
+    free(data);
+    return;
+  }
+  BodyBuffer buffer = {data, len, 0, fin};
+  body_buffers_.push_back(buffer);
+  WriteBodyBuffers();
+}
+
+void GoQuicSimpleServerStream::WriteOrBufferBodyInOrder(base::StringPiece data,
+                                                        bool fin) {
+  if (body_buffers_.empty()) {
+    WriteOrBufferBody(data.as_string(), fin, nullptr);
+    return;
+  }
+  char* copy = nullptr;
+  if (!data.empty()) {
+    copy = static_cast<char*>(malloc(data.size()));
+    memcpy(copy, data.data(), data.size());
+  }
+  WriteBodyBuffer(copy, data.size(), fin);
+}
+
+void GoQuicSimpleServerStream::WriteBodyBuffers() {
+  // Data buffered by WriteOrBufferBody() goes first; OnCanWrite() gets back
+  // here once it has been sent.
+  while (!body_buffers_.empty() && !HasBufferedData() &&
+         !write_side_closed()) {
+    BodyBuffer& buffer = body_buffers_.front();
+    struct iovec iov;
+    iov.iov_base = buffer.data + buffer.offset;
+    iov.iov_len = buffer.len - buffer.offset;
+    QuicConsumedData consumed = WritevBody(&iov, 1, buffer.fin, nullptr);
+    buffer.offset += consumed.bytes_consumed;
+    if (buffer.offset < buffer.len || (buffer.fin && !consumed.fin_consumed)) {
+      // Blocked; the stream is now on the session's write blocked list and
+      // OnCanWrite() resumes from here.
+      return;
+    }
+    free(buffer.data);
+    body_buffers_.pop_front();
+  }
+
+  if (body_buffers_.empty() && has_pending_trailers_) {
+    has_pending_trailers_ = false;
+    QuicSpdyStream::WriteTrailers(std::move(pending_trailers_), nullptr);
+  }
+}
+
 void GoQuicSimpleServerStream::OnClose() {
   net::QuicSpdyStream::OnClose();
 
@@ -1,22 +1,42 @@
 #ifndef GO_QUIC_SIMPLE_SERVER_STREAM_H__
 #define GO_QUIC_SIMPLE_SERVER_STREAM_H__
 
+#include <deque>
 #include <string>
 
+#include "base/strings/string_piece.h"
 #include "net/quic/core/quic_spdy_stream.h"
+#include "go_quic_object_pool.h"
 #include "go_structs.h"
 
 namespace net {
 
 class QuicSpdySession;
 
-class GoQuicSimpleServerStream : public QuicSpdyStream {
+class GoQuicSimpleServerStream
+    : public QuicSpdyStream,
+      public GoQuicPooled<GoQuicSimpleServerStream> {
  public:
   GoQuicSimpleServerStream(QuicStreamId id, QuicSpdySession* session);
   ~GoQuicSimpleServerStream() override;
 
   void SetGoQuicSimpleServerStream(GoPtr go_quic_simple_server_stream);
 
+  // Switches the request body to streaming mode: readable regions are
+  // forwarded to Go as they arrive instead of being collected in body_, and
+  // are only consumed from the sequencer once Go calls MarkBodyConsumed().
+  // Holding on to unconsumed data keeps the flow control window closed, so a
+  // slow handler pushes back on the peer. Must be called from
+  // OnInitialHeadersComplete, before any body data has been delivered.
+  void EnableBodyStreaming();
+
+  // Called once Go's handler has read |num_bytes| of forwarded body data.
+  void MarkBodyConsumed(size_t num_bytes);
+
+  // Called when the handler is done with the request body before reaching
+  // its end.
+  void StopReadingBody();
+
   // QuicSpdyStream
   void OnInitialHeadersComplete(bool fin, size_t frame_len) override;
   void OnTrailingHeadersComplete(bool fin, size_t frame_len) override;
@@ -41,18 +61,59 @@ class GoQuicSimpleServerStream : public QuicSpdyStream {
                       bool fin,
                       QuicAckListenerInterface* ack_notifier_delegate) override;
 
+  // Deferred until every queued body buffer has been written, so that the
+  // trailers carry the right final offset.
+  size_t WriteTrailers(SpdyHeaderBlock trailer_block,
+                       QuicAckListenerInterface* ack_notifier_delegate) override;
+
+  void OnCanWrite() override;
+
+  // Takes ownership of |data|, which must have been allocated with malloc(),
+  // and sends it after everything written before. Data is handed to the
+  // connection straight from |data|, which is freed once it has all been
+  // consumed (or the stream goes away). |data| may be null if |len| is 0.
+  void WriteBodyBuffer(char* data, size_t len, bool fin);
+
+  // Like WriteOrBufferBody(), but ordered after the queued body buffers.
+  void WriteOrBufferBodyInOrder(base::StringPiece data, bool fin);
+
  protected:
   // Sends a basic 500 response using SendHeaders for the headers and WriteData
   // for the body.
   virtual void SendErrorResponse();
 
  private:
+  // Forwards readable data which has not been handed to Go yet, and reports
+  // the end of the body once everything up to the FIN has been consumed.
+  void ForwardBody();
+
+  // Writes queued body buffers until the connection stops consuming, then
+  // sends deferred trailers once the queue is empty.
+  void WriteBodyBuffers();
+
+  struct BodyBuffer {
+    char* data;
+    size_t len;
+    size_t offset;  // Bytes already consumed by the connection
+    bool fin;
+  };
+
   GoPtr go_quic_simple_server_stream_;
 
   SpdyHeaderBlock request_headers_;
   int64_t content_length_;
   std::string body_;
 
+  bool streaming_;
+  // Streaming mode: bytes forwarded to Go but not consumed yet, and the total
+  // number of body bytes forwarded so far.
+  size_t body_pending_;
+  uint64_t body_forwarded_;
+
+  std::deque<BodyBuffer> body_buffers_;
+  bool has_pending_trailers_;
+  SpdyHeaderBlock pending_trailers_;
+
   DISALLOW_COPY_AND_ASSIGN(GoQuicSimpleServerStream);
 };
 
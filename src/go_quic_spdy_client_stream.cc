@@ -63,9 +63,8 @@ void GoQuicSpdyClientStream::OnInitialHeadersComplete(bool fin,
     return;
   }
 
-  auto hdr = CreateGoSpdyHeader(response_headers_);
+  auto hdr = PackGoHeaderBlock(response_headers_);
   GoQuicSpdyClientStreamOnInitialHeadersComplete_C(go_quic_client_stream_, hdr);
-  DeleteGoSpdyHeader(hdr);
 
   MarkHeadersConsumed(decompressed_headers().length());
 
@@ -94,9 +93,8 @@ void GoQuicSpdyClientStream::OnInitialHeadersComplete(
     return;
   }
 
-  auto hdr = CreateGoSpdyHeader(response_headers_);
+  auto hdr = PackGoHeaderBlock(response_headers_);
   GoQuicSpdyClientStreamOnInitialHeadersComplete_C(go_quic_client_stream_, hdr);
-  DeleteGoSpdyHeader(hdr);
 
   ConsumeHeaderList();
   DVLOG(1) << "headers complete for stream " << id();
@@ -110,9 +108,8 @@ void GoQuicSpdyClientStream::OnTrailingHeadersComplete(
     const QuicHeaderList& header_list) {
   QuicSpdyStream::OnTrailingHeadersComplete(fin, frame_len, header_list);
 
-  auto hdr = CreateGoSpdyHeader(received_trailers());
+  auto hdr = PackGoHeaderBlock(received_trailers());
   GoQuicSpdyClientStreamOnTrailingHeadersComplete_C(go_quic_client_stream_, hdr);
-  DeleteGoSpdyHeader(hdr);
 
   MarkTrailersConsumed(decompressed_trailers().length());
 }
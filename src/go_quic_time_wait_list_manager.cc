@@ -5,6 +5,9 @@
 #include "go_quic_time_wait_list_manager.h"
 
 #include <errno.h>
+#include <string.h>
+
+#include <algorithm>
 
 #include "base/logging.h"
 #include "base/stl_util.h"
@@ -50,6 +53,8 @@ class ConnectionIdCleanUpAlarm : public QuicAlarm::Delegate {
 //                  the public reset packet back to the client.
 // packet - the pending public reset packet that is to be sent to the client.
 //          created instance takes the ownership of this packet.
+// Termination packets are queued by reference instead: |shared| keeps the
+// packet at |index| of the connection's termination packets alive.
 class GoQuicTimeWaitListManager::QueuedPacket {
  public:
   QueuedPacket(const IPEndPoint& server_address,
@@ -57,16 +62,28 @@ class GoQuicTimeWaitListManager::QueuedPacket {
                QuicEncryptedPacket* packet)
       : server_address_(server_address),
         client_address_(client_address),
+        owned_packet_(packet),
         packet_(packet) {}
 
+  QueuedPacket(const IPEndPoint& server_address,
+               const IPEndPoint& client_address,
+               const scoped_refptr<GoQuicTerminationPackets>& shared,
+               size_t index)
+      : server_address_(server_address),
+        client_address_(client_address),
+        shared_packets_(shared),
+        packet_(shared->packets()[index].get()) {}
+
   const IPEndPoint& server_address() const { return server_address_; }
   const IPEndPoint& client_address() const { return client_address_; }
-  QuicEncryptedPacket* packet() { return packet_.get(); }
+  const QuicEncryptedPacket* packet() const { return packet_; }
 
  private:
   const IPEndPoint server_address_;
   const IPEndPoint client_address_;
-  std::unique_ptr<QuicEncryptedPacket> packet_;
+  std::unique_ptr<QuicEncryptedPacket> owned_packet_;
+  scoped_refptr<GoQuicTerminationPackets> shared_packets_;
+  const QuicEncryptedPacket* packet_;
 
   DISALLOW_COPY_AND_ASSIGN(QueuedPacket);
 };
@@ -76,7 +93,10 @@ GoQuicTimeWaitListManager::GoQuicTimeWaitListManager(
     QuicServerSessionBase::Visitor* visitor,
     QuicConnectionHelperInterface* helper,
     QuicAlarmFactory* alarm_factory)
-    : time_wait_period_(
+    : connection_id_table_(helper->GetRandomGenerator()->RandUint64()),
+      max_connections_(FLAGS_quic_time_wait_list_max_connections),
+      public_reset_templates_built_(false),
+      time_wait_period_(
           QuicTime::Delta::FromSeconds(FLAGS_quic_time_wait_list_seconds)),
       connection_id_clean_up_alarm_(
           alarm_factory->CreateAlarm(new ConnectionIdCleanUpAlarm(this))),  // alarm's delegate is deleted
@@ -102,21 +122,24 @@ void GoQuicTimeWaitListManager::AddConnectionIdToTimeWait(
         << "have a close packet.  connection_id = " << connection_id;
   }
   int num_packets = 0;
-  ConnectionIdMap::iterator it = connection_id_map_.find(connection_id);
-  const bool new_connection_id = it == connection_id_map_.end();
+  GoQuicTimeWaitTable::Entry* entry = connection_id_table_.Find(connection_id);
+  const bool new_connection_id = entry == nullptr;
   if (!new_connection_id) {  // Replace record if it is reinserted.
-    num_packets = it->second.num_packets;
-    connection_id_map_.erase(it);
+    num_packets = entry->num_packets;
+    connection_id_table_.Erase(entry);
   }
   TrimTimeWaitListIfNeeded();
-  DCHECK_LT(num_connections(),
-            static_cast<size_t>(FLAGS_quic_time_wait_list_max_connections));
-  ConnectionIdData data(num_packets, version, clock_->ApproximateNow(),
-                        connection_rejected_statelessly);
-  if (termination_packets != nullptr) {
-    data.termination_packets.swap(*termination_packets);
+  DCHECK(max_connections_ < 0 ||
+         num_connections() < static_cast<size_t>(max_connections_));
+  entry = connection_id_table_.Insert(connection_id);
+  entry->num_packets = num_packets;
+  entry->version = version;
+  entry->time_added = clock_->ApproximateNow();
+  entry->connection_rejected_statelessly = connection_rejected_statelessly;
+  if (termination_packets != nullptr && !termination_packets->empty()) {
+    entry->termination_packets =
+        new GoQuicTerminationPackets(termination_packets);
   }
-  connection_id_map_.emplace(std::make_pair(connection_id, std::move(data)));
   if (new_connection_id) {
     visitor_->OnConnectionAddedToTimeWaitList(connection_id);
   }
@@ -124,14 +147,15 @@ void GoQuicTimeWaitListManager::AddConnectionIdToTimeWait(
 
 bool GoQuicTimeWaitListManager::IsConnectionIdInTimeWait(
     QuicConnectionId connection_id) const {
-  return base::ContainsKey(connection_id_map_, connection_id);
+  return connection_id_table_.Find(connection_id) != nullptr;
 }
 
 QuicVersion GoQuicTimeWaitListManager::GetQuicVersionFromConnectionId(
     QuicConnectionId connection_id) {
-  ConnectionIdMap::iterator it = connection_id_map_.find(connection_id);
-  DCHECK(it != connection_id_map_.end());
-  return (it->second).version;
+  const GoQuicTimeWaitTable::Entry* entry =
+      connection_id_table_.Find(connection_id);
+  DCHECK(entry != nullptr);
+  return entry->version;
 }
 
 void GoQuicTimeWaitListManager::OnCanWrite() {
@@ -155,27 +179,23 @@ void GoQuicTimeWaitListManager::ProcessPacket(
   DVLOG(1) << "Processing " << connection_id << " in time wait state.";
   // TODO(satyamshekhar): Think about handling packets from different client
   // addresses.
-  ConnectionIdMap::iterator it = connection_id_map_.find(connection_id);
-  DCHECK(it != connection_id_map_.end());
+  GoQuicTimeWaitTable::Entry* connection_data =
+      connection_id_table_.Find(connection_id);
+  DCHECK(connection_data != nullptr);
   // Increment the received packet count.
-  ConnectionIdData* connection_data = &it->second;
   ++(connection_data->num_packets);
 
   if (!ShouldSendResponse(connection_data->num_packets)) {
     return;
   }
 
-  if (!connection_data->termination_packets.empty()) {
+  if (connection_data->termination_packets != nullptr) {
     if (connection_data->connection_rejected_statelessly) {
       DVLOG(3) << "Time wait list sending previous stateless reject response "
                << "for connection " << connection_id;
     }
-    for (const auto& packet : connection_data->termination_packets) {
-      QueuedPacket* queued_packet =
-          new QueuedPacket(server_address, client_address, packet->Clone());
-      // Takes ownership of the packet.
-      SendOrQueuePacket(queued_packet);
-    }
+    SendTerminationPackets(server_address, client_address,
+                           connection_data->termination_packets);
     return;
   }
 
@@ -200,11 +220,134 @@ bool GoQuicTimeWaitListManager::ShouldSendResponse(int received_packet_count) {
   return (received_packet_count & (received_packet_count - 1)) == 0;
 }
 
+void GoQuicTimeWaitListManager::SendTerminationPackets(
+    const IPEndPoint& server_address,
+    const IPEndPoint& client_address,
+    const scoped_refptr<GoQuicTerminationPackets>& termination_packets) {
+  const auto& packets = termination_packets->packets();
+  for (size_t i = 0; i < packets.size(); i++) {
+    if (WriteToWire(*packets[i], server_address, client_address)) {
+      continue;
+    }
+    // Deleted by OnCanWrite() once sent.
+    pending_packets_queue_.push_back(new QueuedPacket(
+        server_address, client_address, termination_packets, i));
+  }
+}
+
+namespace {
+
+// Values the public reset template is built with, and then located by.
+const QuicConnectionId kTemplateConnectionId = UINT64_C(0x5a17c0ded0c0ffee);
+const QuicPacketNumber kTemplatePacketNumber = UINT64_C(0x7e57ab1e5eed5a1f);
+const uint8_t kTemplateClientIp[16] = {0x20, 0x01, 0x0d, 0xb8, 0xc4, 0x7a,
+                                       0x91, 0x3e, 0x5b, 0x08, 0xf2, 0x6d,
+                                       0xa3, 0x17, 0xe9, 0x44};
+const uint16_t kTemplateClientPort = 0xbeef;
+
+// Returns the offset of the only occurrence of |pattern| in |buffer|, or
+// false if there is none or more than one.
+bool FindUnique(const std::vector<char>& buffer,
+                const char* pattern,
+                size_t pattern_len,
+                size_t* offset) {
+  auto it = std::search(buffer.begin(), buffer.end(), pattern,
+                        pattern + pattern_len);
+  if (it == buffer.end() ||
+      std::search(it + 1, buffer.end(), pattern, pattern + pattern_len) !=
+          buffer.end()) {
+    return false;
+  }
+  *offset = it - buffer.begin();
+  return true;
+}
+
+}  // namespace
+
+GoQuicTimeWaitListManager::PublicResetTemplate::PublicResetTemplate()
+    : connection_id_offset(0), packet_number_offset(0), client_ip_offset(0) {}
+
+GoQuicTimeWaitListManager::PublicResetTemplate::~PublicResetTemplate() {}
+
+void GoQuicTimeWaitListManager::BuildPublicResetTemplate(
+    size_t ip_len,
+    PublicResetTemplate* reset_template) {
+  QuicPublicResetPacket packet;
+  packet.public_header.connection_id = kTemplateConnectionId;
+  packet.public_header.reset_flag = true;
+  packet.public_header.version_flag = false;
+  packet.rejected_packet_number = kTemplatePacketNumber;
+  packet.nonce_proof = 1010101;
+  packet.client_address =
+      IPEndPoint(IPAddress(kTemplateClientIp, ip_len), kTemplateClientPort);
+
+  std::unique_ptr<QuicEncryptedPacket> serialized(BuildPublicReset(packet));
+  if (serialized == nullptr) {
+    return;
+  }
+  std::vector<char> buffer(serialized->data(),
+                           serialized->data() + serialized->length());
+
+  // The connection ID, packet number and port are serialized in host byte
+  // order, and the address as its raw bytes.
+  char client[sizeof(kTemplateClientIp) + sizeof(kTemplateClientPort)];
+  memcpy(client, kTemplateClientIp, ip_len);
+  memcpy(client + ip_len, &kTemplateClientPort, sizeof(kTemplateClientPort));
+
+  if (!FindUnique(buffer, reinterpret_cast<const char*>(&kTemplateConnectionId),
+                  sizeof(kTemplateConnectionId),
+                  &reset_template->connection_id_offset) ||
+      !FindUnique(buffer, reinterpret_cast<const char*>(&kTemplatePacketNumber),
+                  sizeof(kTemplatePacketNumber),
+                  &reset_template->packet_number_offset) ||
+      !FindUnique(buffer, client, ip_len + sizeof(kTemplateClientPort),
+                  &reset_template->client_ip_offset)) {
+    LOG(WARNING) << "Cannot build public reset template; resets will be "
+                 << "serialized one by one.";
+    return;
+  }
+  reset_template->buffer.swap(buffer);
+}
+
 void GoQuicTimeWaitListManager::SendPublicReset(
     const IPEndPoint& server_address,
     const IPEndPoint& client_address,
     QuicConnectionId connection_id,
     QuicPacketNumber rejected_packet_number) {
+  if (!public_reset_templates_built_) {
+    BuildPublicResetTemplate(4, &public_reset_template_v4_);
+    BuildPublicResetTemplate(16, &public_reset_template_v6_);
+    public_reset_templates_built_ = true;
+  }
+
+  const std::vector<uint8_t>& client_ip = client_address.address().bytes();
+  PublicResetTemplate* reset_template = client_ip.size() == 4
+                                            ? &public_reset_template_v4_
+                                            : &public_reset_template_v6_;
+  if (!reset_template->buffer.empty() &&
+      (client_ip.size() == 4 || client_ip.size() == 16)) {
+    // Fast path: patch the template and write it straight from there.
+    char* buffer = reset_template->buffer.data();
+    uint16_t port = client_address.port();
+    memcpy(buffer + reset_template->connection_id_offset, &connection_id,
+           sizeof(connection_id));
+    memcpy(buffer + reset_template->packet_number_offset,
+           &rejected_packet_number, sizeof(rejected_packet_number));
+    memcpy(buffer + reset_template->client_ip_offset, client_ip.data(),
+           client_ip.size());
+    memcpy(buffer + reset_template->client_ip_offset + client_ip.size(), &port,
+           sizeof(port));
+
+    QuicEncryptedPacket packet(buffer, reset_template->buffer.size());
+    if (!WriteToWire(packet, server_address, client_address)) {
+      // Only copied if it has to wait for the writer. Deleted by
+      // OnCanWrite() once sent.
+      pending_packets_queue_.push_back(
+          new QueuedPacket(server_address, client_address, packet.Clone()));
+    }
+    return;
+  }
+
   QuicPublicResetPacket packet;
   packet.public_header.connection_id = connection_id;
   packet.public_header.reset_flag = true;
@@ -238,14 +381,20 @@ void GoQuicTimeWaitListManager::SendOrQueuePacket(QueuedPacket* packet) {
 }
 
 bool GoQuicTimeWaitListManager::WriteToWire(QueuedPacket* queued_packet) {
+  return WriteToWire(*queued_packet->packet(), queued_packet->server_address(),
+                     queued_packet->client_address());
+}
+
+bool GoQuicTimeWaitListManager::WriteToWire(const QuicEncryptedPacket& packet,
+                                            const IPEndPoint& server_address,
+                                            const IPEndPoint& client_address) {
   if (writer_->IsWriteBlocked()) {
     visitor_->OnWriteBlocked(this);
     return false;
   }
-  WriteResult result = writer_->WritePacket(
-      queued_packet->packet()->data(), queued_packet->packet()->length(),
-      queued_packet->server_address().address(),
-      queued_packet->client_address(), nullptr);
+  WriteResult result =
+      writer_->WritePacket(packet.data(), packet.length(),
+                           server_address.address(), client_address, nullptr);
   if (result.status == WRITE_STATUS_BLOCKED) {
     // If blocked and unbuffered, return false to retry sending.
     DCHECK(writer_->IsWriteBlocked());
@@ -253,7 +402,7 @@ bool GoQuicTimeWaitListManager::WriteToWire(QueuedPacket* queued_packet) {
     return writer_->IsWriteBlockedDataBuffered();
   } else if (result.status == WRITE_STATUS_ERROR) {
     LOG(WARNING) << "Received unknown error while sending reset packet to "
-                 << queued_packet->client_address().ToString() << ": "
+                 << client_address.ToString() << ": "
                  << strerror(result.error_code);
   }
   return true;
@@ -262,9 +411,8 @@ bool GoQuicTimeWaitListManager::WriteToWire(QueuedPacket* queued_packet) {
 void GoQuicTimeWaitListManager::SetConnectionIdCleanUpAlarm() {
   connection_id_clean_up_alarm_->Cancel();
   QuicTime::Delta next_alarm_interval = QuicTime::Delta::Zero();
-  if (!connection_id_map_.empty()) {
-    QuicTime oldest_connection_id =
-        connection_id_map_.begin()->second.time_added;
+  if (!connection_id_table_.empty()) {
+    QuicTime oldest_connection_id = connection_id_table_.Oldest()->time_added;
     QuicTime now = clock_->ApproximateNow();
     if ((now - oldest_connection_id) < time_wait_period_) {
       next_alarm_interval =
@@ -283,17 +431,16 @@ void GoQuicTimeWaitListManager::SetConnectionIdCleanUpAlarm() {
 
 bool GoQuicTimeWaitListManager::MaybeExpireOldestConnection(
     QuicTime expiration_time) {
-  if (connection_id_map_.empty()) {
+  GoQuicTimeWaitTable::Entry* oldest = connection_id_table_.Oldest();
+  if (oldest == nullptr) {
     return false;
   }
-  ConnectionIdMap::iterator it = connection_id_map_.begin();
-  QuicTime oldest_connection_id_time = it->second.time_added;
-  if (oldest_connection_id_time > expiration_time) {
+  if (oldest->time_added > expiration_time) {
     // Too recent, don't retire.
     return false;
   }
   // This connection_id has lived its age, retire it now.
-  connection_id_map_.erase(it);
+  connection_id_table_.Erase(oldest);
   return true;
 }
 
@@ -308,28 +455,12 @@ void GoQuicTimeWaitListManager::CleanUpOldConnectionIds() {
 }
 
 void GoQuicTimeWaitListManager::TrimTimeWaitListIfNeeded() {
-  if (FLAGS_quic_time_wait_list_max_connections < 0) {
+  if (max_connections_ < 0) {
     return;
   }
-  while (num_connections() >=
-         static_cast<size_t>(FLAGS_quic_time_wait_list_max_connections)) {
-    MaybeExpireOldestConnection(QuicTime::Infinite());
+  while (num_connections() >= static_cast<size_t>(max_connections_) &&
+         MaybeExpireOldestConnection(QuicTime::Infinite())) {
   }
 }
 
-GoQuicTimeWaitListManager::ConnectionIdData::ConnectionIdData(
-    int num_packets_,
-    QuicVersion version_,
-    QuicTime time_added_,
-    bool connection_rejected_statelessly)
-    : num_packets(num_packets_),
-      version(version_),
-      time_added(time_added_),
-      connection_rejected_statelessly(connection_rejected_statelessly) {}
-
-GoQuicTimeWaitListManager::ConnectionIdData::ConnectionIdData(
-    ConnectionIdData&& other) = default;
-
-GoQuicTimeWaitListManager::ConnectionIdData::~ConnectionIdData() {}
-
 }  // namespace net
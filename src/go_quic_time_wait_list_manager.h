@@ -12,7 +12,6 @@
 #include <deque>
 #include <memory>
 
-#include "net/base/linked_hash_map.h"
 #include "net/quic/core/quic_blocked_writer_interface.h"
 #include "net/quic/core/quic_connection.h"
 #include "net/quic/core/quic_framer.h"
@@ -20,6 +19,8 @@
 #include "net/quic/core/quic_protocol.h"
 #include "net/quic/core/quic_server_session_base.h"
 
+#include "go_quic_time_wait_table.h"
+
 namespace net {
 
 namespace test {
@@ -93,7 +94,15 @@ class GoQuicTimeWaitListManager : public QuicBlockedWriterInterface {
   QuicVersion GetQuicVersionFromConnectionId(QuicConnectionId connection_id);
 
   // The number of connections on the time-wait list.
-  size_t num_connections() const { return connection_id_map_.size(); }
+  size_t num_connections() const { return connection_id_table_.size(); }
+
+  // Caps the time-wait list at |max_connections| entries, evicting the
+  // oldest ones first; negative means unlimited. Defaults to
+  // FLAGS_quic_time_wait_list_max_connections.
+  void set_max_connections(int max_connections) {
+    max_connections_ = max_connections;
+    TrimTimeWaitListIfNeeded();
+  }
 
   // Sends a version negotiation packet for |connection_id| announcing support
   // for |supported_versions| to |client_address| from |server_address|.
@@ -117,6 +126,32 @@ class GoQuicTimeWaitListManager : public QuicBlockedWriterInterface {
   // number of received packets.
   bool ShouldSendResponse(int received_packet_count);
 
+  // Sends the termination packets of a connection, queueing references to
+  // them, rather than copies, if the writer is blocked.
+  void SendTerminationPackets(
+      const IPEndPoint& server_address,
+      const IPEndPoint& client_address,
+      const scoped_refptr<GoQuicTerminationPackets>& termination_packets);
+
+  // A public reset serialized once per address family, with the offsets of
+  // the fields that differ from one reset to the next. Sending a reset only
+  // patches those fields in place.
+  struct PublicResetTemplate {
+    PublicResetTemplate();
+    ~PublicResetTemplate();
+
+    std::vector<char> buffer;  // Empty if the template could not be built
+    size_t connection_id_offset;
+    size_t packet_number_offset;
+    size_t client_ip_offset;  // Followed by the client port
+  };
+
+  // Serializes |reset_template| for client addresses of |ip_len| bytes.
+  // Leaves it empty if the marker values cannot be located unambiguously,
+  // in which case resets are built from scratch.
+  void BuildPublicResetTemplate(size_t ip_len,
+                                PublicResetTemplate* reset_template);
+
   // Creates a public reset packet and sends it or queues it to be sent later.
   void SendPublicReset(const IPEndPoint& server_address,
                        const IPEndPoint& client_address,
@@ -132,45 +167,32 @@ class GoQuicTimeWaitListManager : public QuicBlockedWriterInterface {
   // the packet and retry sending. In case of all other errors we drop the
   // packet.
   bool WriteToWire(QueuedPacket* packet);
+  bool WriteToWire(const QuicEncryptedPacket& packet,
+                   const IPEndPoint& server_address,
+                   const IPEndPoint& client_address);
 
   // Register the alarm to wake up at appropriate time.
   void SetConnectionIdCleanUpAlarm();
 
   // Removes the oldest connection from the time-wait list if it was added prior
   // to "expiration_time".  To unconditionally remove the oldest connection, use
-  // a QuicTime::Delta:Infinity().  This function modifies the
-  // connection_id_map_.  If you plan to call this function in a loop, any
-  // iterators that you hold before the call to this function may be invalid
-  // afterward.  Returns true if the oldest connection was expired.  Returns
-  // false if the map is empty or the oldest connection has not expired.
+  // a QuicTime::Delta:Infinity().  Returns true if the oldest connection was
+  // expired.  Returns false if the table is empty or the oldest connection has
+  // not expired.
   bool MaybeExpireOldestConnection(QuicTime expiration_time);
 
-  // A map from a recently closed connection_id to the number of packets
-  // received after the termination of the connection bound to the
-  // connection_id.
-  struct ConnectionIdData {
-    ConnectionIdData(int num_packets_,
-                     QuicVersion version_,
-                     QuicTime time_added_,
-                     bool connection_rejected_statelessly);
-
-    ConnectionIdData(const ConnectionIdData& other) = delete;
-    ConnectionIdData(ConnectionIdData&& other);
-
+  // Recently closed connection_ids, with the number of packets received after
+  // the termination of the connection bound to each of them. Iterated in add
+  // order by expiry.
+  GoQuicTimeWaitTable connection_id_table_;
 
-    ~ConnectionIdData();
-
-    int num_packets;
-    QuicVersion version;
-    QuicTime time_added;
-    // These packets may contain CONNECTION_CLOSE frames, or SREJ messages.
-    std::vector<std::unique_ptr<QuicEncryptedPacket>> termination_packets;
-    bool connection_rejected_statelessly;
-  };
+  // See set_max_connections().
+  int max_connections_;
 
-  // linked_hash_map allows lookup by ConnectionId and traversal in add order.
-  typedef linked_hash_map<QuicConnectionId, ConnectionIdData> ConnectionIdMap;
-  ConnectionIdMap connection_id_map_;
+  // Public reset templates for IPv4 and IPv6 clients, built on first use.
+  bool public_reset_templates_built_;
+  PublicResetTemplate public_reset_template_v4_;
+  PublicResetTemplate public_reset_template_v6_;
 
   // Pending public reset packets that need to be sent out to the client
   // when we are given a chance to write by the dispatcher.
@@ -0,0 +1,161 @@
+#include "go_quic_time_wait_table.h"
+
+#include "base/logging.h"
+
+namespace net {
+
+const uint32_t GoQuicTimeWaitTable::kNil;
+const size_t GoQuicTimeWaitTable::kInitialBuckets;
+
+GoQuicTerminationPackets::GoQuicTerminationPackets(
+    std::vector<std::unique_ptr<QuicEncryptedPacket>>* packets) {
+  packets_.swap(*packets);
+}
+
+GoQuicTerminationPackets::~GoQuicTerminationPackets() {}
+
+GoQuicTimeWaitTable::Entry::Entry()
+    : connection_id(0),
+      time_added(QuicTime::Zero()),
+      num_packets(0),
+      version(QUIC_VERSION_UNSUPPORTED),
+      connection_rejected_statelessly(false),
+      prev(kNil),
+      next(kNil) {}
+
+GoQuicTimeWaitTable::GoQuicTimeWaitTable(uint64_t seed)
+    : seed_(seed), size_(0), free_(kNil), oldest_(kNil), newest_(kNil) {
+  Bucket empty = {0, kNil};
+  buckets_.assign(kInitialBuckets, empty);
+}
+
+GoQuicTimeWaitTable::~GoQuicTimeWaitTable() {}
+
+size_t GoQuicTimeWaitTable::Home(QuicConnectionId connection_id) const {
+  // Fibonacci hashing of the seeded ID, folding the well mixed high bits
+  // into the low ones used as the index.
+  uint64_t hash = (connection_id ^ seed_) * 0x9E3779B97F4A7C15ull;
+  hash ^= hash >> 32;
+  return static_cast<size_t>(hash) & (buckets_.size() - 1);
+}
+
+size_t GoQuicTimeWaitTable::Probe(QuicConnectionId connection_id) const {
+  const size_t mask = buckets_.size() - 1;
+  size_t i = Home(connection_id);
+  while (buckets_[i].entry != kNil &&
+         buckets_[i].connection_id != connection_id) {
+    i = (i + 1) & mask;
+  }
+  return i;
+}
+
+uint32_t GoQuicTimeWaitTable::IndexOf(const Entry* entry) const {
+  DCHECK(entry >= entries_.data() && entry < entries_.data() + entries_.size());
+  return static_cast<uint32_t>(entry - entries_.data());
+}
+
+GoQuicTimeWaitTable::Entry* GoQuicTimeWaitTable::Find(
+    QuicConnectionId connection_id) {
+  const Bucket& bucket = buckets_[Probe(connection_id)];
+  return bucket.entry == kNil ? nullptr : &entries_[bucket.entry];
+}
+
+const GoQuicTimeWaitTable::Entry* GoQuicTimeWaitTable::Find(
+    QuicConnectionId connection_id) const {
+  const Bucket& bucket = buckets_[Probe(connection_id)];
+  return bucket.entry == kNil ? nullptr : &entries_[bucket.entry];
+}
+
+GoQuicTimeWaitTable::Entry* GoQuicTimeWaitTable::Insert(
+    QuicConnectionId connection_id) {
+  // Keep the load factor at or below 1/2 so probe sequences stay short.
+  if ((size_ + 1) * 2 > buckets_.size()) {
+    Rehash(buckets_.size() * 2);
+  }
+
+  size_t b = Probe(connection_id);
+  DCHECK_EQ(kNil, buckets_[b].entry) << "Duplicate " << connection_id;
+
+  uint32_t index;
+  if (free_ != kNil) {
+    index = free_;
+    free_ = entries_[index].next;
+    entries_[index] = Entry();
+  } else {
+    index = static_cast<uint32_t>(entries_.size());
+    entries_.push_back(Entry());
+  }
+
+  Entry* entry = &entries_[index];
+  entry->connection_id = connection_id;
+  entry->prev = newest_;
+  entry->next = kNil;
+  if (newest_ != kNil) {
+    entries_[newest_].next = index;
+  } else {
+    oldest_ = index;
+  }
+  newest_ = index;
+
+  buckets_[b].connection_id = connection_id;
+  buckets_[b].entry = index;
+  size_++;
+  return entry;
+}
+
+void GoQuicTimeWaitTable::Erase(Entry* entry) {
+  const uint32_t index = IndexOf(entry);
+  const size_t mask = buckets_.size() - 1;
+
+  // Backward shift deletion: move later members of the probe run into the
+  // hole, so that lookups never need tombstones.
+  size_t hole = Probe(entry->connection_id);
+  DCHECK_EQ(index, buckets_[hole].entry);
+  for (size_t j = (hole + 1) & mask; buckets_[j].entry != kNil;
+       j = (j + 1) & mask) {
+    size_t home = Home(buckets_[j].connection_id);
+    // The bucket at |j| may move back to |hole| unless its home lies
+    // cyclically in (hole, j].
+    bool home_in_range = hole <= j ? (hole < home && home <= j)
+                                   : (hole < home || home <= j);
+    if (!home_in_range) {
+      buckets_[hole] = buckets_[j];
+      hole = j;
+    }
+  }
+  buckets_[hole].entry = kNil;
+
+  if (entry->prev != kNil) {
+    entries_[entry->prev].next = entry->next;
+  } else {
+    oldest_ = entry->next;
+  }
+  if (entry->next != kNil) {
+    entries_[entry->next].prev = entry->prev;
+  } else {
+    newest_ = entry->prev;
+  }
+
+  // Drop the packets now rather than when the entry is reused.
+  entry->termination_packets = nullptr;
+  entry->prev = kNil;
+  entry->next = free_;
+  free_ = index;
+  size_--;
+}
+
+GoQuicTimeWaitTable::Entry* GoQuicTimeWaitTable::Oldest() {
+  return oldest_ == kNil ? nullptr : &entries_[oldest_];
+}
+
+void GoQuicTimeWaitTable::Rehash(size_t num_buckets) {
+  Bucket empty = {0, kNil};
+  buckets_.assign(num_buckets, empty);
+  for (uint32_t i = oldest_; i != kNil; i = entries_[i].next) {
+    size_t b = Probe(entries_[i].connection_id);
+    buckets_[b].connection_id = entries_[i].connection_id;
+    buckets_[b].entry = i;
+  }
+}
+
+}  // namespace net
@@ -0,0 +1,120 @@
+#ifndef GO_QUIC_TIME_WAIT_TABLE_H_
+#define GO_QUIC_TIME_WAIT_TABLE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <vector>
+
+#include "base/macros.h"
+#include "base/memory/ref_counted.h"
+#include "net/quic/core/quic_protocol.h"
+#include "net/quic/core/quic_time.h"
+
+namespace net {
+
+// Termination packets (CONNECTION_CLOSE frames or SREJ messages) of one
+// connection. They are taken over from the connection once, and shared by its
+// time-wait entry and any response queued while the writer is blocked, so
+// they never have to be cloned.
+class GoQuicTerminationPackets
+    : public base::RefCounted<GoQuicTerminationPackets> {
+ public:
+  // Takes the packets out of |packets|.
+  explicit GoQuicTerminationPackets(
+      std::vector<std::unique_ptr<QuicEncryptedPacket>>* packets);
+
+  const std::vector<std::unique_ptr<QuicEncryptedPacket>>& packets() const {
+    return packets_;
+  }
+
+ private:
+  friend class base::RefCounted<GoQuicTerminationPackets>;
+  ~GoQuicTerminationPackets();
+
+  std::vector<std::unique_ptr<QuicEncryptedPacket>> packets_;
+
+  DISALLOW_COPY_AND_ASSIGN(GoQuicTerminationPackets);
+};
+
+// Set of connection IDs in time-wait state. Entries have a fixed size and
+// live in one array; they are found through an open-addressing (linear
+// probing) index, and kept in insertion order by an intrusive list, which is
+// also the order in which they expire.
+//
+// Entry pointers stay valid until the next Insert().
+class GoQuicTimeWaitTable {
+ public:
+  struct Entry {
+    Entry();
+
+    QuicConnectionId connection_id;
+    QuicTime time_added;
+    // Null if a public reset should be sent instead.
+    scoped_refptr<GoQuicTerminationPackets> termination_packets;
+    int num_packets;
+    QuicVersion version;
+    bool connection_rejected_statelessly;
+
+   private:
+    friend class GoQuicTimeWaitTable;
+
+    // Expiry list links, or free list link for unused entries.
+    uint32_t prev;
+    uint32_t next;
+  };
+
+  // |seed| randomizes the hash, so that clients choosing their connection
+  // IDs cannot force long probe sequences.
+  explicit GoQuicTimeWaitTable(uint64_t seed);
+  ~GoQuicTimeWaitTable();
+
+  // Returns null if |connection_id| is not in the table.
+  Entry* Find(QuicConnectionId connection_id);
+  const Entry* Find(QuicConnectionId connection_id) const;
+
+  // Adds |connection_id|, which must not be in the table yet, as the newest
+  // entry. Its fields other than connection_id are reset.
+  Entry* Insert(QuicConnectionId connection_id);
+
+  void Erase(Entry* entry);
+
+  // The entry added first, or null if the table is empty.
+  Entry* Oldest();
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+ private:
+  static const uint32_t kNil = 0xffffffff;
+  static const size_t kInitialBuckets = 64;
+
+  struct Bucket {
+    QuicConnectionId connection_id;
+    uint32_t entry;  // Index into |entries_|, or kNil if the bucket is empty
+  };
+
+  size_t Home(QuicConnectionId connection_id) const;
+  // Returns the bucket holding |connection_id|, or the empty bucket where it
+  // would be inserted.
+  size_t Probe(QuicConnectionId connection_id) const;
+  void Rehash(size_t num_buckets);
+  uint32_t IndexOf(const Entry* entry) const;
+
+  const uint64_t seed_;
+
+  std::vector<Bucket> buckets_;  // Size is a power of two
+  std::vector<Entry> entries_;
+  size_t size_;
+
+  uint32_t free_;    // Head of the list of unused entries
+  uint32_t oldest_;  // Head and tail of the expiry list
+  uint32_t newest_;
+
+  DISALLOW_COPY_AND_ASSIGN(GoQuicTimeWaitTable);
+};
+
+}  // namespace net
+
+#endif  // GO_QUIC_TIME_WAIT_TABLE_H_
@@ -0,0 +1,309 @@
+#include "go_quic_timer_wheel.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "base/logging.h"
+
+namespace net {
+
+namespace {
+
+const int64_t kNoDeadline = std::numeric_limits<int64_t>::max();
+
+int64_t ToMicroseconds(QuicTime time) {
+  return (time - QuicTime::Zero()).ToMicroseconds();
+}
+
+// Leaves headroom for rounding up to a whole tick.
+const int64_t kMaxDeadlineUs = kNoDeadline / 2;
+
+}  // namespace
+
+GoQuicTimerWheel::Timer::Timer(GoQuicTimerWheel* wheel)
+    : wheel_(wheel), deadline_tick_(0), slot_(0) {
+  link_.prev = nullptr;
+  link_.next = nullptr;
+  link_.owner = this;
+}
+
+GoQuicTimerWheel::Timer::~Timer() {
+  if (wheel_ != nullptr && IsScheduled()) {
+    wheel_->Unlink(this);
+  }
+}
+
+GoQuicTimerWheel::GoQuicTimerWheel()
+    : clock_(new QuicClock()), metrics_(nullptr) {
+  for (size_t i = 0; i < arraysize(slots_); i++) {
+    InitList(&slots_[i]);
+  }
+  for (size_t i = 0; i < arraysize(occupied_); i++) {
+    occupied_[i] = 0;
+  }
+  InitList(&ready_);
+  InitList(&firing_);
+
+  state_.Now = NowUs();
+  state_.Next_deadline = kNoDeadline;
+  current_tick_ = state_.Now / kTickUs;
+}
+
+GoQuicTimerWheel::~GoQuicTimerWheel() {
+  // Alarms may outlive the wheel while their connections are torn down.
+  // Detach them so that they no longer reference it.
+  Link* lists[] = {&ready_, &firing_};
+  for (Link* head : lists) {
+    while (!IsEmpty(head)) {
+      Timer* timer = head->next->owner;
+      Unlink(timer);
+      timer->wheel_ = nullptr;
+    }
+  }
+  for (size_t i = 0; i < arraysize(slots_); i++) {
+    while (!IsEmpty(&slots_[i])) {
+      Timer* timer = slots_[i].next->owner;
+      Unlink(timer);
+      timer->wheel_ = nullptr;
+    }
+  }
+}
+
+void GoQuicTimerWheel::InitList(Link* head) {
+  head->prev = head;
+  head->next = head;
+  head->owner = nullptr;
+}
+
+void GoQuicTimerWheel::MoveList(Link* from, Link* to) {
+  DCHECK(IsEmpty(to));
+  if (IsEmpty(from)) {
+    return;
+  }
+  to->next = from->next;
+  to->prev = from->prev;
+  to->next->prev = to;
+  to->prev->next = to;
+  InitList(from);
+}
+
+void GoQuicTimerWheel::Append(Link* head, Timer* timer, int slot) {
+  Link* link = &timer->link_;
+  link->prev = head->prev;
+  link->next = head;
+  head->prev->next = link;
+  head->prev = link;
+  timer->slot_ = slot;
+  if (slot >= 0) {
+    occupied_[slot / 64] |= static_cast<uint64_t>(1) << (slot % 64);
+  }
+}
+
+void GoQuicTimerWheel::Unlink(Timer* timer) {
+  Link* link = &timer->link_;
+  link->prev->next = link->next;
+  link->next->prev = link->prev;
+  link->prev = nullptr;
+  link->next = nullptr;
+
+  int slot = timer->slot_;
+  if (slot >= 0 && IsEmpty(&slots_[slot])) {
+    occupied_[slot / 64] &= ~(static_cast<uint64_t>(1) << (slot % 64));
+  }
+}
+
+bool GoQuicTimerWheel::IsOccupied(int slot) const {
+  return (occupied_[slot / 64] & (static_cast<uint64_t>(1) << (slot % 64))) !=
+         0;
+}
+
+void GoQuicTimerWheel::Place(Timer* timer) {
+  // Levels are relative to the next tick to be collected, which is also the
+  // tick any cascade calling this is run for.
+  const int64_t base = current_tick_ + 1;
+  int64_t deadline_tick = timer->deadline_tick_;
+  DCHECK_GE(deadline_tick, base);
+
+  int level = 0;
+  while (level < kNumLevels - 1 &&
+         deadline_tick - base >= static_cast<int64_t>(1)
+                                     << (kSlotBits * (level + 1))) {
+    level++;
+  }
+  // Deadlines beyond the last level are filed at its far end, and placed
+  // again from there.
+  deadline_tick = std::min(
+      deadline_tick,
+      base + (static_cast<int64_t>(1) << (kSlotBits * kNumLevels)) - 1);
+
+  int slot = level * kNumSlots +
+             static_cast<int>((deadline_tick >> (kSlotBits * level)) &
+                              (kNumSlots - 1));
+  Append(&slots_[slot], timer, slot);
+}
+
+void GoQuicTimerWheel::Schedule(Timer* timer, QuicTime deadline) {
+  DCHECK_EQ(this, timer->wheel_);
+  if (timer->IsScheduled()) {
+    Unlink(timer);
+  }
+
+  // Round up so that a timer never fires before its deadline.
+  int64_t deadline_us = std::min(ToMicroseconds(deadline), kMaxDeadlineUs);
+  int64_t deadline_tick = (deadline_us + kTickUs - 1) / kTickUs;
+  timer->deadline_tick_ = deadline_tick;
+
+  if (deadline_tick <= current_tick_) {
+    Append(&ready_, timer, kReadyList);
+    state_.Next_deadline = state_.Now;
+    return;
+  }
+
+  Place(timer);
+  if (deadline_tick * kTickUs < state_.Next_deadline) {
+    state_.Next_deadline = deadline_tick * kTickUs;
+  }
+}
+
+void GoQuicTimerWheel::Cancel(Timer* timer) {
+  DCHECK_EQ(this, timer->wheel_);
+  if (timer->IsScheduled()) {
+    // Next_deadline is left as is. It may now be early, which only costs a
+    // spurious wakeup.
+    Unlink(timer);
+  }
+}
+
+void GoQuicTimerWheel::Cascade(int level, int64_t tick) {
+  int index =
+      static_cast<int>((tick >> (kSlotBits * level)) & (kNumSlots - 1));
+  int slot = level * kNumSlots + index;
+  if (IsOccupied(slot)) {
+    // Detach the slot first, so that timers placed again never rejoin it.
+    Link pending;
+    InitList(&pending);
+    MoveList(&slots_[slot], &pending);
+    occupied_[slot / 64] &= ~(static_cast<uint64_t>(1) << (slot % 64));
+    while (!IsEmpty(&pending)) {
+      Timer* timer = pending.next->owner;
+      Unlink(timer);
+      Place(timer);
+    }
+  }
+  if (index == 0 && level + 1 < kNumLevels) {
+    Cascade(level + 1, tick);
+  }
+}
+
+void GoQuicTimerWheel::CollectSlot(int slot) {
+  Link* head = &slots_[slot];
+  while (!IsEmpty(head)) {
+    Timer* timer = head->next->owner;
+    DCHECK_LE(timer->deadline_tick_, current_tick_ + 1);
+    Unlink(timer);
+    Append(&ready_, timer, kReadyList);
+  }
+}
+
+void GoQuicTimerWheel::FireExpired() {
+  int64_t now_us = NowUs();
+  int64_t now_tick = now_us / kTickUs;
+
+  while (current_tick_ < now_tick) {
+    int64_t tick = current_tick_ + 1;
+    int index = static_cast<int>(tick & (kNumSlots - 1));
+    if (index == 0) {
+      Cascade(1, tick);
+    }
+    if (IsOccupied(index)) {
+      CollectSlot(index);
+    }
+    current_tick_ = tick;
+
+    // Skip the ticks before the next occupied slot or the next wrap around,
+    // whichever comes first.
+    int distance =
+        NextOccupiedDistance(0, static_cast<int>((tick + 1) & (kNumSlots - 1)));
+    int to_wrap = kNumSlots - 1 - index;
+    if (distance < 0 || distance > to_wrap) {
+      distance = to_wrap;
+    }
+    current_tick_ = std::min(now_tick, tick + distance);
+  }
+  state_.Now = now_us;
+
+  // Run a snapshot of the ready list. Timers rescheduled to the past while
+  // running are picked up by the next call, which Go makes right away since
+  // Next_deadline is then already due.
+  if (!IsEmpty(&ready_)) {
+    MoveList(&ready_, &firing_);
+    for (Link* link = firing_.next; link != &firing_; link = link->next) {
+      link->owner->slot_ = kFiringList;
+    }
+
+    uint64_t fired = 0;
+    while (!IsEmpty(&firing_)) {
+      Timer* timer = firing_.next->owner;
+      Unlink(timer);
+      // May cancel, reschedule or delete any timer, including this one.
+      timer->OnExpire();
+      fired++;
+    }
+    if (metrics_ != nullptr) {
+      metrics_->Increment(GoQuicDispatcherMetrics::kAlarmsFired, fired);
+    }
+  }
+
+  UpdateNextDeadline();
+}
+
+int GoQuicTimerWheel::NextOccupiedDistance(int level, int start) const {
+  const int kWords = kNumSlots / 64;
+  const uint64_t* occupied = &occupied_[level * kWords];
+
+  // Scan from |start| to the end of the level, then wrap around; the word
+  // holding |start| is visited twice with complementary masks.
+  for (int i = 0; i <= kWords; i++) {
+    int word = (start / 64 + i) % kWords;
+    uint64_t bits = occupied[word];
+    if (i == 0) {
+      bits &= ~static_cast<uint64_t>(0) << (start % 64);
+    } else if (i == kWords) {
+      bits &= (static_cast<uint64_t>(1) << (start % 64)) - 1;
+    }
+    if (bits != 0) {
+      int slot = word * 64 + __builtin_ctzll(bits);
+      return (slot - start + kNumSlots) % kNumSlots;
+    }
+  }
+  return -1;
+}
+
+void GoQuicTimerWheel::UpdateNextDeadline() {
+  if (!IsEmpty(&ready_)) {
+    state_.Next_deadline = state_.Now;
+    return;
+  }
+
+  // Level 0 gives the exact tick of its next timers. A slot of a higher
+  // level holds no timer due before the tick at which it cascades, the start
+  // of its span, which makes that tick a lower bound.
+  int64_t next_tick = kNoDeadline;
+  for (int level = 0; level < kNumLevels; level++) {
+    const int shift = kSlotBits * level;
+    int64_t first_span = (current_tick_ >> shift) + 1;
+    int distance = NextOccupiedDistance(
+        level, static_cast<int>(first_span & (kNumSlots - 1)));
+    if (distance >= 0) {
+      next_tick = std::min(next_tick, (first_span + distance) << shift);
+    }
+  }
+  state_.Next_deadline =
+      next_tick == kNoDeadline ? kNoDeadline : next_tick * kTickUs;
+}
+
+int64_t GoQuicTimerWheel::NowUs() const {
+  return ToMicroseconds(clock_->Now());
+}
+
+}  // namespace net
@@ -0,0 +1,145 @@
+#ifndef GO_QUIC_TIMER_WHEEL_H_
+#define GO_QUIC_TIMER_WHEEL_H_
+
+#include <memory>
+
+#include "base/macros.h"
+#include "net/quic/core/quic_clock.h"
+#include "net/quic/core/quic_time.h"
+#include "go_quic_dispatcher_metrics.h"
+#include "go_structs.h"
+
+namespace net {
+
+// Hashed timing wheel driving all QuicAlarms of one event loop (a dispatcher
+// or a client connection). Timers are kept in intrusive lists, so scheduling
+// and cancelling are O(1) and allocation free.
+//
+// The wheel has kNumLevels levels of kNumSlots slots. Slots of level 0 are
+// 1ms, and each slot of a higher level spans a whole revolution of the level
+// below. A timer goes to the lowest level whose revolution reaches its
+// deadline and cascades down whenever the level below wraps around to its
+// slot, so every timer on level 0 is due exactly at its slot's tick and long
+// idle timers are only touched once per level. Timers never fire before
+// their deadline, and at most 1ms after it.
+//
+// Go never calls into the wheel to find out when to wake up: it reads
+// GoQuicTimerWheelState directly and calls FireExpired() when that deadline
+// passes.
+class GoQuicTimerWheel {
+ public:
+  class Timer {
+   public:
+    explicit Timer(GoQuicTimerWheel* wheel);
+    virtual ~Timer();
+
+    bool IsScheduled() const { return link_.prev != nullptr; }
+
+   protected:
+    // Called by FireExpired() once the deadline has passed. The timer is no
+    // longer scheduled at this point.
+    virtual void OnExpire() = 0;
+
+    GoQuicTimerWheel* wheel() const { return wheel_; }
+
+   private:
+    friend class GoQuicTimerWheel;
+
+    struct Link {
+      Link* prev;
+      Link* next;
+      Timer* owner;
+    };
+
+    // Null once the wheel has been destroyed.
+    GoQuicTimerWheel* wheel_;
+    Link link_;
+    int64_t deadline_tick_;
+    // Index into slots_ (level * kNumSlots + slot), or one of the k*List
+    // values below.
+    int slot_;
+
+    DISALLOW_COPY_AND_ASSIGN(Timer);
+  };
+
+  GoQuicTimerWheel();
+  ~GoQuicTimerWheel();
+
+  const QuicClock* clock() const { return clock_.get(); }
+
+  // Shared with Go, which reads it without calling into C++.
+  GoQuicTimerWheelState* state() { return &state_; }
+
+  // (Re)schedules |timer| to expire at |deadline|.
+  void Schedule(Timer* timer, QuicTime deadline);
+  void Cancel(Timer* timer);
+
+  // Runs every timer whose deadline has passed and updates state().
+  void FireExpired();
+
+  // Fired timers are counted in |metrics| from now on. Not owned; must
+  // outlive the wheel.
+  void set_metrics(GoQuicDispatcherMetrics* metrics) { metrics_ = metrics; }
+
+ private:
+  typedef Timer::Link Link;
+
+  static const int kTickUs = 1000;
+  static const int kSlotBits = 9;
+  static const int kNumSlots = 1 << kSlotBits;  // Per level
+  // Levels reach 512ms, 4 minutes, 37 hours and 2 years. Later deadlines
+  // wait in the last level and are placed again when it gets to them.
+  static const int kNumLevels = 4;
+  static const int kReadyList = -1;
+  static const int kFiringList = -2;
+
+  static void InitList(Link* head);
+  static bool IsEmpty(const Link* head) { return head->next == head; }
+  // Moves all of |from| to the empty list |to|.
+  static void MoveList(Link* from, Link* to);
+  void Append(Link* head, Timer* timer, int slot);
+  void Unlink(Timer* timer);
+  bool IsOccupied(int slot) const;
+
+  // Files |timer|, which is due after current_tick_, in the lowest level
+  // that reaches its deadline.
+  void Place(Timer* timer);
+
+  // Places the timers of |level|'s slot for |tick| again, now that the level
+  // below has wrapped around to it, and recurses if |level| wrapped too.
+  void Cascade(int level, int64_t tick);
+
+  // Moves the timers of level 0 slot |slot|, which are all due, to the ready
+  // list.
+  void CollectSlot(int slot);
+
+  // Returns the distance (0..kNumSlots-1) from slot |start| of |level| to its
+  // next occupied slot, or -1 if the level is empty.
+  int NextOccupiedDistance(int level, int start) const;
+
+  void UpdateNextDeadline();
+  int64_t NowUs() const;
+
+  std::unique_ptr<QuicClock> clock_;
+
+  Link slots_[kNumLevels * kNumSlots];
+  uint64_t occupied_[kNumLevels * kNumSlots / 64];
+
+  // Timers which are due but have not been run yet.
+  Link ready_;
+  // Timers being run by the current FireExpired() call.
+  Link firing_;
+
+  // Every slot up to and including this tick has been collected.
+  int64_t current_tick_;
+
+  GoQuicTimerWheelState state_;
+
+  GoQuicDispatcherMetrics* metrics_;  // May be null
+
+  DISALLOW_COPY_AND_ASSIGN(GoQuicTimerWheel);
+};
+
+}  // namespace net
+
+#endif  // GO_QUIC_TIMER_WHEEL_H_
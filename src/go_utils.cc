@@ -1,36 +1,127 @@
 #include "go_utils.h"
 #include "net/spdy/spdy_header_block.h"
 
+#include <string.h>
+
+#include <vector>
+
 namespace net {
 
-GoSpdyHeader* CreateGoSpdyHeader(const SpdyHeaderBlock& header_block) {
-  size_t N = header_block.size();
-  GoSpdyHeader* hdr = new GoSpdyHeader;
+namespace {
+
+struct HeaderPackBuffer {
+  // 2 * N uint32_t lengths followed by the header strings.
+  std::vector<char> buffer;
+  GoHeaderBlock block;
+  GoRequestHeaders request;
+};
+
+thread_local HeaderPackBuffer header_pack_buffer;
+
+const int kNumPseudoHeaders = 5;
+
+// Position of |key| among the GoRequestHeaders fields, or -1.
+int RequestPseudoHeaderIndex(base::StringPiece key) {
+  if (key.empty() || key[0] != ':') {
+    return -1;
+  }
+  if (key == ":method") {
+    return 0;
+  } else if (key == ":path") {
+    return 1;
+  } else if (key == ":authority") {
+    return 2;
+  } else if (key == ":scheme") {
+    return 3;
+  } else if (key == ":version") {
+    return 4;
+  }
+  return -1;
+}
+
+// Packs |header_block| into |block|. If |pseudo_lens| is given, request
+// pseudo-headers are stored ahead of the other headers and their lengths in
+// |pseudo_lens| instead.
+void Pack(const SpdyHeaderBlock& header_block,
+          int32_t* pseudo_lens,
+          GoHeaderBlock* block) {
+  base::StringPiece pseudo[kNumPseudoHeaders];
+  if (pseudo_lens != nullptr) {
+    for (int i = 0; i < kNumPseudoHeaders; i++) {
+      pseudo_lens[i] = -1;
+    }
+  }
 
-  hdr->N = N;
-  hdr->Keys = new const char*[N];
-  hdr->Values = new const char*[N];
-  hdr->Keys_len = new int[N];
-  hdr->Values_len = new int[N];
+  size_t N = 0;
+  size_t data_len = 0;
+  for (auto it = header_block.begin(); it != header_block.end(); it++) {
+    if (pseudo_lens != nullptr) {
+      int index = RequestPseudoHeaderIndex(it->first);
+      if (index >= 0) {
+        pseudo[index] = it->second;
+        pseudo_lens[index] = it->second.length();
+        data_len += it->second.length();
+        continue;
+      }
+    }
+    N++;
+    data_len += it->first.length() + it->second.length();
+  }
+
+  size_t lens_size = 2 * N * sizeof(uint32_t);
+  std::vector<char>& buffer = header_pack_buffer.buffer;
+  if (buffer.size() < lens_size + data_len) {
+    buffer.resize(lens_size + data_len);
+  }
 
-  int idx = 0;
-  for(auto it = header_block.begin(); it != header_block.end(); it++, idx++) {
-    auto p = *it;
-    hdr->Keys[idx] = p.first.data();
-    hdr->Keys_len[idx] = p.first.length();
-    hdr->Values[idx] = p.second.data();
-    hdr->Values_len[idx] = p.second.length();
+  // std::vector storage is suitably aligned for the lengths.
+  uint32_t* lens = reinterpret_cast<uint32_t*>(buffer.data());
+  char* data = buffer.data() + lens_size;
+  char* p = data;
+  if (pseudo_lens != nullptr) {
+    for (int i = 0; i < kNumPseudoHeaders; i++) {
+      memcpy(p, pseudo[i].data(), pseudo[i].length());
+      p += pseudo[i].length();
+    }
   }
+  for (auto it = header_block.begin(); it != header_block.end(); it++) {
+    base::StringPiece key = it->first;
+    base::StringPiece value = it->second;
+    if (pseudo_lens != nullptr && RequestPseudoHeaderIndex(key) >= 0) {
+      continue;
+    }
+    *lens++ = key.length();
+    *lens++ = value.length();
+    memcpy(p, key.data(), key.length());
+    p += key.length();
+    memcpy(p, value.data(), value.length());
+    p += value.length();
+  }
+
+  block->N = N;
+  block->Lens = reinterpret_cast<const uint32_t*>(buffer.data());
+  block->Data = data;
+  block->Data_len = data_len;
+}
+
+}  // namespace
 
-  return hdr;
+GoHeaderBlock* PackGoHeaderBlock(const SpdyHeaderBlock& header_block) {
+  GoHeaderBlock* block = &header_pack_buffer.block;
+  Pack(header_block, nullptr, block);
+  return block;
 }
 
-void DeleteGoSpdyHeader(GoSpdyHeader* go_header) {
-  delete(go_header->Keys);
-  delete(go_header->Keys_len);
-  delete(go_header->Values);
-  delete(go_header->Values_len);
-  delete(go_header);
+GoRequestHeaders* PackGoRequestHeaders(const SpdyHeaderBlock& header_block) {
+  GoRequestHeaders* request = &header_pack_buffer.request;
+  int32_t pseudo_lens[kNumPseudoHeaders];
+  Pack(header_block, pseudo_lens, &request->Headers);
+  request->Method_len = pseudo_lens[0];
+  request->Path_len = pseudo_lens[1];
+  request->Authority_len = pseudo_lens[2];
+  request->Scheme_len = pseudo_lens[3];
+  request->Version_len = pseudo_lens[4];
+  return request;
 }
 
 void CreateSpdyHeaderBlock(SpdyHeaderBlock& block, int N, char* key_ptr, int* key_len, char* value_ptr, int* value_len) {
@@ -7,8 +7,15 @@ namespace net {
 
 class SpdyHeaderBlock;
 
-GoSpdyHeader* CreateGoSpdyHeader(const SpdyHeaderBlock& header_block);
-void DeleteGoSpdyHeader(GoSpdyHeader* go_header);
+// Packs |header_block| into a buffer owned by the calling thread, so that
+// steady state marshalling allocates nothing. The result is only valid until
+// the next call on the same thread; Go copies it out right away.
+GoHeaderBlock* PackGoHeaderBlock(const SpdyHeaderBlock& header_block);
+
+// Like PackGoHeaderBlock(), but extracts :method, :path, :authority, :scheme
+// and :version into the fixed fields of GoRequestHeaders, so that Go can
+// build the request line without looking them up.
+GoRequestHeaders* PackGoRequestHeaders(const SpdyHeaderBlock& header_block);
 void CreateSpdyHeaderBlock(SpdyHeaderBlock& block, int N, char* key_ptr, int* key_len, char* value_ptr, int* value_len);
 
 }
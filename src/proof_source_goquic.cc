@@ -2,15 +2,47 @@
 
 #include "base/logging.h"
 
+#include <openssl/rsa.h>
+
 #include "go_functions.h"
 #include "net/base/ip_address.h"
+#include "net/quic/core/crypto/crypto_protocol.h"
 
 namespace net {
 
+namespace {
+
+// Go dispatcher owning the calling thread. Each dispatcher runs on a locked
+// OS thread, so this identifies the loop an async GetProof() belongs to.
+thread_local GoPtr thread_dispatcher = 0;
+
+// Signing jobs that may be queued per signing thread. Beyond that GetProof
+// signs on the dispatcher thread.
+const size_t kSigningJobQueueSize = 64;
+
+}  // namespace
+
 ProofSourceGoquic::ProofSourceGoquic(GoPtr go_proof_source)
-    : go_proof_source_(go_proof_source) {}
+    : go_proof_source_(go_proof_source),
+      private_key_(nullptr),
+      signature_cache_(kSignatureCacheSize),
+      signature_cache_hits_(0),
+      signature_cache_misses_(0),
+      max_signing_queue_(0),
+      stopping_(false) {}
 
 ProofSourceGoquic::~ProofSourceGoquic() {
+  {
+    std::lock_guard<std::mutex> lock(signing_mutex_);
+    stopping_ = true;
+  }
+  signing_cv_.notify_all();
+  for (std::thread& thread : signing_threads_) {
+    thread.join();
+  }
+  if (private_key_ != nullptr) {
+    EVP_PKEY_free(private_key_);
+  }
   ReleaseProofSource_C(go_proof_source_);
 }
 
@@ -22,6 +54,113 @@ void ProofSourceGoquic::BuildCertChain() {
   chain_ = new ProofSource::Chain(certs_);
 }
 
+bool ProofSourceGoquic::SetPrivateKey(const char* der, size_t der_sz) {
+  const uint8_t* p = reinterpret_cast<const uint8_t*>(der);
+  EVP_PKEY* key = d2i_AutoPrivateKey(nullptr, &p, der_sz);
+  if (key == nullptr) {
+    return false;
+  }
+  int type = EVP_PKEY_id(key);
+  if (type != EVP_PKEY_RSA && type != EVP_PKEY_EC) {
+    EVP_PKEY_free(key);
+    return false;
+  }
+
+  if (private_key_ != nullptr) {
+    EVP_PKEY_free(private_key_);
+  }
+  private_key_ = key;
+  return true;
+}
+
+void ProofSourceGoquic::StartSigningThreads(int num_threads) {
+  DCHECK(private_key_ != nullptr);
+  DCHECK(signing_threads_.empty());
+  max_signing_queue_ = num_threads * kSigningJobQueueSize;
+  for (int i = 0; i < num_threads; i++) {
+    signing_threads_.push_back(
+        std::thread(&ProofSourceGoquic::SigningThreadMain, this));
+  }
+}
+
+bool ProofSourceGoquic::EnqueueSigningJob(GoQuicGetProofJob* job) {
+  {
+    std::lock_guard<std::mutex> lock(signing_mutex_);
+    if (signing_queue_.size() >= max_signing_queue_) {
+      return false;
+    }
+    signing_queue_.push_back(job);
+  }
+  signing_cv_.notify_one();
+  return true;
+}
+
+void ProofSourceGoquic::SigningThreadMain() {
+  for (;;) {
+    GoQuicGetProofJob* job;
+    {
+      std::unique_lock<std::mutex> lock(signing_mutex_);
+      signing_cv_.wait(lock,
+                       [this] { return stopping_ || !signing_queue_.empty(); });
+      if (signing_queue_.empty()) {
+        return;  // Stopping, and every queued job has been handed back
+      }
+      job = signing_queue_.front();
+      signing_queue_.pop_front();
+    }
+
+    job->ok = SignNatively(job->server_config, job->quic_version,
+                           job->chlo_hash, &job->signature);
+    // Posts the job to the dispatcher's loop, which completes it.
+    ProofSigned_C(job->go_quic_dispatcher, job);
+  }
+}
+
+bool ProofSourceGoquic::SignNatively(const std::string& server_config,
+                                     QuicVersion quic_version,
+                                     base::StringPiece chlo_hash,
+                                     std::string* out_signature) const {
+  DCHECK(private_key_ != nullptr);
+
+  EVP_MD_CTX ctx;
+  EVP_MD_CTX_init(&ctx);
+  EVP_PKEY_CTX* pkey_ctx = nullptr;
+  bool ok = EVP_DigestSignInit(&ctx, &pkey_ctx, EVP_sha256(), nullptr,
+                               private_key_) == 1;
+  if (ok && EVP_PKEY_id(private_key_) == EVP_PKEY_RSA) {
+    ok = EVP_PKEY_CTX_set_rsa_padding(pkey_ctx, RSA_PKCS1_PSS_PADDING) == 1 &&
+         EVP_PKEY_CTX_set_rsa_pss_saltlen(pkey_ctx, -1) == 1;
+  }
+
+  // Same message as ProofSource.GetProof() in Go; the labels include their
+  // terminating NUL.
+  if (ok && static_cast<int>(quic_version) > 30) {
+    uint32_t chlo_hash_len = static_cast<uint32_t>(chlo_hash.size());
+    ok = EVP_DigestSignUpdate(&ctx, kProofSignatureLabel,
+                              sizeof(kProofSignatureLabel)) == 1 &&
+         EVP_DigestSignUpdate(&ctx, &chlo_hash_len, sizeof(chlo_hash_len)) == 1 &&
+         EVP_DigestSignUpdate(&ctx, chlo_hash.data(), chlo_hash.size()) == 1;
+  } else if (ok) {
+    ok = EVP_DigestSignUpdate(&ctx, kProofSignatureLabelOld,
+                              sizeof(kProofSignatureLabelOld)) == 1;
+  }
+  ok = ok && EVP_DigestSignUpdate(&ctx, server_config.data(),
+                                  server_config.size()) == 1;
+
+  size_t signature_sz = 0;
+  ok = ok && EVP_DigestSignFinal(&ctx, nullptr, &signature_sz) == 1;
+  if (ok) {
+    out_signature->resize(signature_sz);
+    ok = EVP_DigestSignFinal(
+             &ctx, reinterpret_cast<uint8_t*>(&(*out_signature)[0]),
+             &signature_sz) == 1;
+    out_signature->resize(signature_sz);
+  }
+
+  EVP_MD_CTX_cleanup(&ctx);
+  return ok;
+}
+
 // ProofSource interface
 bool ProofSourceGoquic::GetProof(const net::IPAddress& server_ip,
                              const std::string& hostname,
@@ -31,6 +170,161 @@ bool ProofSourceGoquic::GetProof(const net::IPAddress& server_ip,
                              scoped_refptr<ProofSource::Chain>* out_chain,
                              std::string* out_signature,
                              std::string* out_leaf_cert_sct) {
+  std::string key = SignatureCacheKey(quic_version, server_config, chlo_hash);
+  if (!LookupSignature(key, out_signature)) {
+    if (!Sign(server_ip, hostname, server_config, quic_version, chlo_hash,
+              out_signature)) {
+      return false;
+    }
+    InsertSignature(key, *out_signature);
+  }
+
+  *out_chain = chain_;
+  return true;
+}
+
+void ProofSourceGoquic::GetProof(const IPAddress& server_ip,
+                                   const std::string& hostname,
+                                   const std::string& server_config,
+                                   QuicVersion quic_version,
+                                   base::StringPiece chlo_hash,
+                                   std::unique_ptr<Callback> callback) {
+  std::string key = SignatureCacheKey(quic_version, server_config, chlo_hash);
+  std::string signature;
+  if (LookupSignature(key, &signature)) {
+    callback->Run(true, chain_, signature, std::string() /* leaf_cert_sct */,
+                  nullptr /* details */);
+    return;
+  }
+
+  if (thread_dispatcher != 0) {
+    GoQuicGetProofJob* job = new GoQuicGetProofJob;
+    job->callback = std::move(callback);
+    job->chain = chain_;
+    job->proof_source = this;
+    job->signature_cache_key = std::move(key);
+
+    if (!signing_threads_.empty()) {
+      job->go_quic_dispatcher = thread_dispatcher;
+      job->server_config = server_config;
+      job->quic_version = quic_version;
+      chlo_hash.CopyToString(&job->chlo_hash);
+      job->ok = false;
+      if (EnqueueSigningJob(job)) {
+        return;
+      }
+    } else {
+      auto server_ip_bytes = server_ip.bytes();
+      if (GetProofAsync_C(go_proof_source_, thread_dispatcher, job,
+                          reinterpret_cast<char*>(server_ip_bytes.data()), server_ip_bytes.size(),
+                          (char*)hostname.data(), hostname.length(),
+                          (char*)server_config.data(), server_config.length(),
+                          (int)quic_version,
+                          (char*)chlo_hash.data(), chlo_hash.length())) {
+        return;
+      }
+    }
+
+    // No workers, or they are all busy: sign on this thread instead.
+    callback = std::move(job->callback);
+    key = std::move(job->signature_cache_key);
+    delete job;
+  }
+
+  const bool ok = Sign(server_ip, hostname, server_config, quic_version,
+                       chlo_hash, &signature);
+  if (ok) {
+    InsertSignature(key, signature);
+  }
+  callback->Run(ok, chain_, signature, std::string() /* leaf_cert_sct */,
+                nullptr /* details */);
+}
+
+void ProofSourceGoquic::SetThreadDispatcher(GoPtr go_quic_dispatcher) {
+  thread_dispatcher = go_quic_dispatcher;
+}
+
+void ProofSourceGoquic::CompleteGetProof(GoQuicGetProofJob* job,
+                                         bool ok,
+                                         const char* signature,
+                                         size_t signature_sz) {
+  std::unique_ptr<GoQuicGetProofJob> job_ptr(job);
+  std::string signature_str(signature, signature_sz);
+  if (ok) {
+    job->proof_source->InsertSignature(job->signature_cache_key,
+                                       signature_str);
+  }
+  job->callback->Run(ok, job->chain, signature_str,
+                     std::string() /* leaf_cert_sct */, nullptr /* details */);
+}
+
+// static
+void ProofSourceGoquic::CompleteSignedProof(GoQuicGetProofJob* job) {
+  std::unique_ptr<GoQuicGetProofJob> job_ptr(job);
+  if (job->ok) {
+    job->proof_source->InsertSignature(job->signature_cache_key,
+                                       job->signature);
+  }
+  job->callback->Run(job->ok, job->chain, job->signature,
+                     std::string() /* leaf_cert_sct */, nullptr /* details */);
+}
+
+void ProofSourceGoquic::GetSignatureCacheStats(uint64_t* hits,
+                                               uint64_t* misses) {
+  base::AutoLock locked(signature_cache_lock_);
+  *hits = signature_cache_hits_;
+  *misses = signature_cache_misses_;
+}
+
+// static
+std::string ProofSourceGoquic::SignatureCacheKey(
+    QuicVersion quic_version,
+    const std::string& server_config,
+    base::StringPiece chlo_hash) {
+  // Mirrors what is signed: versions up to 30 sign the server config alone.
+  std::string key;
+  key.reserve(sizeof(uint32_t) * 2 + chlo_hash.size() + server_config.size());
+  uint32_t version = static_cast<uint32_t>(quic_version);
+  key.append(reinterpret_cast<const char*>(&version), sizeof(version));
+  if (static_cast<int>(quic_version) > 30) {
+    uint32_t chlo_hash_len = static_cast<uint32_t>(chlo_hash.size());
+    key.append(reinterpret_cast<const char*>(&chlo_hash_len),
+               sizeof(chlo_hash_len));
+    chlo_hash.AppendToString(&key);
+  }
+  key.append(server_config);
+  return key;
+}
+
+bool ProofSourceGoquic::LookupSignature(const std::string& key,
+                                        std::string* signature) {
+  base::AutoLock locked(signature_cache_lock_);
+  auto it = signature_cache_.Get(key);
+  if (it == signature_cache_.end()) {
+    signature_cache_misses_++;
+    return false;
+  }
+  signature_cache_hits_++;
+  *signature = it->second;
+  return true;
+}
+
+void ProofSourceGoquic::InsertSignature(const std::string& key,
+                                        const std::string& signature) {
+  base::AutoLock locked(signature_cache_lock_);
+  signature_cache_.Put(key, signature);
+}
+
+bool ProofSourceGoquic::Sign(const IPAddress& server_ip,
+                             const std::string& hostname,
+                             const std::string& server_config,
+                             QuicVersion quic_version,
+                             base::StringPiece chlo_hash,
+                             std::string* out_signature) {
+  if (private_key_ != nullptr) {
+    return SignNatively(server_config, quic_version, chlo_hash, out_signature);
+  }
+
   char* c_out_signature;
   size_t c_out_signature_sz;
 
@@ -49,31 +343,10 @@ bool ProofSourceGoquic::GetProof(const net::IPAddress& server_ip,
     return false;
   }
 
-  std::string signature(c_out_signature, c_out_signature_sz);
+  out_signature->assign(c_out_signature, c_out_signature_sz);
   free(c_out_signature);  // Created from go side
 
-  *out_chain = chain_;
-  *out_signature = signature;
-
   return true;
-
-  //TODO(hodduc): cache?
-}
-
-void ProofSourceGoquic::GetProof(const IPAddress& server_ip,
-                                   const std::string& hostname,
-                                   const std::string& server_config,
-                                   QuicVersion quic_version,
-                                   base::StringPiece chlo_hash,
-                                   std::unique_ptr<Callback> callback) {
-  // As a transitional implementation, just call the synchronous version of
-  // GetProof, then invoke the callback with the results and destroy it.
-  scoped_refptr<ProofSource::Chain> chain;
-  std::string signature;
-  std::string leaf_cert_sct;
-  const bool ok = GetProof(server_ip, hostname, server_config, quic_version,
-                           chlo_hash, &chain, &signature, &leaf_cert_sct);
-  callback->Run(ok, chain, signature, leaf_cert_sct, nullptr /* details */);
 }
 
 }    // namespace net
@@ -1,8 +1,19 @@
 #ifndef __PROOF_SOURCE_GOQUIC__H__
 #define __PROOF_SOURCE_GOQUIC__H__
 
+#include <condition_variable>
+#include <deque>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 
+#include <openssl/evp.h>
+
+#include "base/containers/mru_cache.h"
+#include "base/synchronization/lock.h"
 #include "net/quic/core/crypto/proof_source.h"
 #include "net/base/host_port_pair.h"
 #include "go_structs.h"
@@ -10,9 +21,34 @@
 namespace net {
 
 class IPAddress;
+class ProofSourceGoquic;
+
+// A GetProof() request handed to Go's signing workers or to the native
+// signing threads. Completed (and deleted) by
+// ProofSourceGoquic::CompleteGetProof() on the thread of the dispatcher that
+// issued it.
+struct GoQuicGetProofJob {
+  std::unique_ptr<ProofSource::Callback> callback;
+  scoped_refptr<ProofSource::Chain> chain;
+  ProofSourceGoquic* proof_source;
+  std::string signature_cache_key;
+
+  // Only used by the native signing threads, which sign |server_config| and
+  // |chlo_hash| into |signature| and hand the job back to |go_quic_dispatcher|.
+  GoPtr go_quic_dispatcher;
+  std::string server_config;
+  QuicVersion quic_version;
+  std::string chlo_hash;
+  bool ok;
+  std::string signature;
+};
 
 // This should be thread-safe, because multiple dispatcher may concurrently call
 // GetProof()
+//
+// Signatures are cached: they only depend on the server config (and, since
+// QUIC version 31, the CHLO hash), so returning clients and every client of
+// an old version reuse them without another RSA operation or call into Go.
 class ProofSourceGoquic : public ProofSource {
  public:
   ProofSourceGoquic(GoPtr go_proof_source);
@@ -40,11 +76,82 @@ class ProofSourceGoquic : public ProofSource {
                 base::StringPiece chlo_hash,
                 std::unique_ptr<Callback> callback) override;
 
+  // Registers the Go dispatcher running on the calling thread. Asynchronous
+  // GetProof() calls made from this thread complete on that dispatcher's
+  // loop; without one they are answered synchronously.
+  static void SetThreadDispatcher(GoPtr go_quic_dispatcher);
+
+  static void CompleteGetProof(GoQuicGetProofJob* job,
+                               bool ok,
+                               const char* signature,
+                               size_t signature_sz);
+
+  void GetSignatureCacheStats(uint64_t* hits, uint64_t* misses);
+
+  // Loads the certificate's private key (DER: PKCS#1 RSA, SEC1 EC or
+  // PKCS#8), after which proofs are signed with BoringSSL instead of by the
+  // Go ProofSource. Must be called before the source is in use.
+  bool SetPrivateKey(const char* der, size_t der_sz);
+  bool HasPrivateKey() const { return private_key_ != nullptr; }
+
+  // Signs asynchronous GetProof() requests on |num_threads| C++ threads,
+  // without calling into Go until the proof is handed back to its
+  // dispatcher. Requires SetPrivateKey(); must be called before the source is
+  // in use.
+  void StartSigningThreads(int num_threads);
+
+  // Completes a job signed by a signing thread.
+  static void CompleteSignedProof(GoQuicGetProofJob* job);
+
+  // Signs with the key given to SetPrivateKey(): RSA-PSS (SHA-256, salt as
+  // long as the digest) for RSA keys, ECDSA with SHA-256 otherwise.
+  bool SignNatively(const std::string& server_config,
+                    QuicVersion quic_version,
+                    base::StringPiece chlo_hash,
+                    std::string* out_signature) const;
+
  private:
+  static const size_t kSignatureCacheSize = 1024;
+
+  static std::string SignatureCacheKey(QuicVersion quic_version,
+                                       const std::string& server_config,
+                                       base::StringPiece chlo_hash);
+
+  // Counts a hit or miss.
+  bool LookupSignature(const std::string& key, std::string* signature);
+  void InsertSignature(const std::string& key, const std::string& signature);
+
+  // Signs natively or through the Go ProofSource, bypassing the cache.
+  bool Sign(const IPAddress& server_ip,
+            const std::string& hostname,
+            const std::string& server_config,
+            QuicVersion quic_version,
+            base::StringPiece chlo_hash,
+            std::string* out_signature);
+
+  // Queues |job| for the signing threads. Returns false if they are
+  // saturated.
+  bool EnqueueSigningJob(GoQuicGetProofJob* job);
+  void SigningThreadMain();
+
   GoPtr go_proof_source_;
   //std::map<std::string, std::vector<std::string>*> certs_cache_;
   std::vector<std::string> certs_;
   scoped_refptr<ProofSource::Chain> chain_;
+  EVP_PKEY* private_key_;  // Owned; null unless signing natively
+
+  base::Lock signature_cache_lock_;
+  base::MRUCache<std::string, std::string> signature_cache_;
+  uint64_t signature_cache_hits_;
+  uint64_t signature_cache_misses_;
+
+  std::vector<std::thread> signing_threads_;
+  std::mutex signing_mutex_;
+  std::condition_variable signing_cv_;
+  std::deque<GoQuicGetProofJob*> signing_queue_;  // Guarded by signing_mutex_
+  size_t max_signing_queue_;
+  bool stopping_;  // Guarded by signing_mutex_
+
   DISALLOW_COPY_AND_ASSIGN(ProofSourceGoquic);
 };
 
@@ -5,11 +5,28 @@ package goquic
 import "C"
 
 type ServerStatistics struct {
+	// Aggregated counters, one entry per dispatcher
+	Dispatchers []DispatcherMetrics
+
+	// Connection stats of up to QuicSpdyServer.SessionStatisticsSample
+	// sessions per dispatcher
 	SessionStatistics []SessionStatistics
+
+	// Proof signatures served from the signature cache, and signed afresh
+	SignatureCacheHits   uint64
+	SignatureCacheMisses uint64
+
+	// Object pool occupancy, one entry per dispatcher
+	PoolStatistics []PoolStatistics
 }
 
 type DispatcherStatistics struct {
 	SessionStatistics []SessionStatistics
+	PoolStatistics    PoolStatistics
+}
+
+type PoolStatistics struct {
+	Pstat C.struct_GoQuicPoolStats
 }
 
 type SessionStatistics struct {
@@ -4,10 +4,7 @@ package goquic
 // #include "src/adaptor.h"
 import "C"
 import (
-	"bytes"
-	"fmt"
 	"net/http"
-	"strings"
 	"unsafe"
 )
 
@@ -19,6 +16,22 @@ type DataStreamProcessor interface {
 	OnClose()
 }
 
+// Request pseudo-headers, extracted by the C++ stream
+type RequestPseudoHeaders struct {
+	Method    string
+	Path      string
+	Authority string
+	Scheme    string
+	Version   string
+}
+
+// Optionally implemented by server side DataStreamProcessors. If it is, it is
+// called instead of OnInitialHeadersComplete, with canonical header names
+// and without pseudo-headers in |header|.
+type RequestHeadersProcessor interface {
+	OnRequestHeadersComplete(pseudo RequestPseudoHeaders, header http.Header, peerAddress string)
+}
+
 //   (~= QuicServerSession)
 type IncomingDataStreamCreator interface {
 	CreateIncomingDynamicStream(quicServerStream *QuicServerStream, streamId uint32) DataStreamProcessor
@@ -45,55 +58,122 @@ type QuicStream interface {
 
 */
 
-func createHeader(headers_c *C.struct_GoSpdyHeader) http.Header {
-	h := make(http.Header)
-	N := int(headers_c.N)
+func createHeader(block *C.struct_GoHeaderBlock) http.Header {
+	N := int(block.N)
+	h := make(http.Header, N)
+	if N == 0 {
+		return h
+	}
+
+	// One copy for the whole block; keys and values are substrings of it.
+	data := C.GoStringN(block.Data, C.int(block.Data_len))
+	addHeaderBlock(h, block, data, 0, internHeaderName)
+	return h
+}
 
-	keysArray := (*[1 << 30](*C.char))(unsafe.Pointer(headers_c.Keys))[:N:N]
-	valuesArray := (*[1 << 30](*C.char))(unsafe.Pointer(headers_c.Values))[:N:N]
+// addHeaderBlock adds the headers of |block|, whose strings start at |off| in
+// |data|, to |h| under the names given by |name|.
+func addHeaderBlock(h http.Header, block *C.struct_GoHeaderBlock, data string, off int, name func(string) string) {
+	N := int(block.N)
+	if N == 0 {
+		return
+	}
+	lens := (*[1 << 28]C.uint32_t)(unsafe.Pointer(block.Lens))[: 2*N : 2*N]
 
-	keysLen := (*[1 << 30]C.int)(unsafe.Pointer(headers_c.Keys_len))[:N:N]
-	valuesLen := (*[1 << 30]C.int)(unsafe.Pointer(headers_c.Values_len))[:N:N]
+	// Backing store for the values, as most headers have just one.
+	values := make([]string, N)
 
 	for i := 0; i < N; i++ {
-		key := C.GoStringN(keysArray[i], keysLen[i])
-		value := C.GoStringN(valuesArray[i], valuesLen[i])
+		keyLen, valueLen := int(lens[2*i]), int(lens[2*i+1])
+		key := name(data[off : off+keyLen])
+		off += keyLen
+		values[i] = data[off : off+valueLen]
+		off += valueLen
 
 		if v, ok := h[key]; !ok {
-			h[key] = []string{value}
+			h[key] = values[i : i+1 : i+1]
 		} else {
-			h[key] = append(v, value)
+			h[key] = append(v, values[i])
 		}
 	}
-
-	return h
 }
 
-func digSpdyHeader(header http.Header) ([]byte, []C.int, []byte, []C.int) {
-	var keys, values bytes.Buffer
-	var keylen, valuelen []C.int
+// createRequestHeader returns the request pseudo-headers, and the other
+// headers keyed by their canonical names like net/http does.
+func createRequestHeader(request *C.struct_GoRequestHeaders) (RequestPseudoHeaders, http.Header) {
+	block := &request.Headers
+	data := C.GoStringN(block.Data, C.int(block.Data_len))
+
+	var pseudo RequestPseudoHeaders
+	off := 0
+	for _, p := range []struct {
+		len   C.int32_t
+		value *string
+	}{
+		{request.Method_len, &pseudo.Method},
+		{request.Path_len, &pseudo.Path},
+		{request.Authority_len, &pseudo.Authority},
+		{request.Scheme_len, &pseudo.Scheme},
+		{request.Version_len, &pseudo.Version},
+	} {
+		if p.len > 0 {
+			*p.value = data[off : off+int(p.len)]
+			off += int(p.len)
+		}
+	}
 
-	keylen = make([]C.int, 0, len(header))
-	valuelen = make([]C.int, 0, len(header))
+	h := make(http.Header, int(block.N))
+	addHeaderBlock(h, block, data, off, canonicalHeaderName)
+	return pseudo, h
+}
 
-	for key, mvalue := range header {
-		for index := range mvalue {
+// toHeader returns |h| together with the pseudo-headers, keyed by wire names.
+func (pseudo *RequestPseudoHeaders) toHeader(h http.Header) http.Header {
+	wire := make(http.Header, len(h)+5)
+	for k, v := range h {
+		wire[wireHeaderName(k)] = v
+	}
+	for _, p := range []struct{ name, value string }{
+		{":method", pseudo.Method},
+		{":path", pseudo.Path},
+		{":authority", pseudo.Authority},
+		{":scheme", pseudo.Scheme},
+		{":version", pseudo.Version},
+	} {
+		if p.value != "" {
+			wire[p.name] = []string{p.value}
+		}
+	}
+	return wire
+}
 
-			// Due to spdy_utils.cc, all trailer headers key should be lower-case (why?)
-			nk, errk := keys.WriteString(strings.ToLower(key))
-			nv, errv := values.WriteString(mvalue[index])
+func digSpdyHeader(header http.Header) ([]byte, []C.int, []byte, []C.int) {
+	n, keysSize, valuesSize := 0, 0, 0
+	for key, mvalue := range header {
+		n += len(mvalue)
+		keysSize += len(key) * len(mvalue)
+		for _, value := range mvalue {
+			valuesSize += len(value)
+		}
+	}
 
-			keylen = append(keylen, C.int(nk))
-			valuelen = append(valuelen, C.int(nv))
+	keys := make([]byte, 0, keysSize)
+	values := make([]byte, 0, valuesSize)
+	keylen := make([]C.int, 0, n)
+	valuelen := make([]C.int, 0, n)
 
-			if errk != nil || errv != nil {
-				fmt.Println("buffer write failed", errk, errv)
-				break
-			}
+	for key, mvalue := range header {
+		// Due to spdy_utils.cc, all trailer headers key should be lower-case (why?)
+		name := wireHeaderName(key)
+		for _, value := range mvalue {
+			keys = append(keys, name...)
+			values = append(values, value...)
+			keylen = append(keylen, C.int(len(name)))
+			valuelen = append(valuelen, C.int(len(value)))
 		}
 	}
 
-	return keys.Bytes(), keylen, values.Bytes(), valuelen
+	return keys, keylen, values, valuelen
 }
 
 //export CreateIncomingDynamicStream
@@ -113,11 +193,15 @@ func CreateIncomingDynamicStream(session_key int64, stream_id uint32, wrapper_c
 }
 
 //export GoQuicSimpleServerStreamOnInitialHeadersComplete
-func GoQuicSimpleServerStreamOnInitialHeadersComplete(quic_server_stream_key int64, headers_c *C.struct_GoSpdyHeader, peer_addr unsafe.Pointer, peer_addr_len uint32) {
+func GoQuicSimpleServerStreamOnInitialHeadersComplete(quic_server_stream_key int64, headers_c *C.struct_GoRequestHeaders, peer_addr unsafe.Pointer, peer_addr_len uint32) {
 	stream := quicServerStreamPtr.Get(quic_server_stream_key)
-	header := createHeader(headers_c)
+	pseudo, header := createRequestHeader(headers_c)
 	peerAddr := C.GoStringN((*C.char)(peer_addr), (C.int)(peer_addr_len))
-	stream.UserStream().OnInitialHeadersComplete(header, peerAddr)
+	if p, ok := stream.UserStream().(RequestHeadersProcessor); ok {
+		p.OnRequestHeadersComplete(pseudo, header, peerAddr)
+	} else {
+		stream.UserStream().OnInitialHeadersComplete(pseudo.toHeader(header), peerAddr)
+	}
 }
 
 //export GoQuicSimpleServerStreamOnDataAvailable
@@ -134,14 +218,14 @@ func GoQuicSimpleServerStreamOnClose(quic_server_stream_key int64) {
 }
 
 //export GoQuicSpdyClientStreamOnInitialHeadersComplete
-func GoQuicSpdyClientStreamOnInitialHeadersComplete(quic_client_stream_key int64, headers_c *C.struct_GoSpdyHeader) {
+func GoQuicSpdyClientStreamOnInitialHeadersComplete(quic_client_stream_key int64, headers_c *C.struct_GoHeaderBlock) {
 	stream := quicClientStreamPtr.Get(quic_client_stream_key)
 	header := createHeader(headers_c)
 	stream.UserStream().OnInitialHeadersComplete(header, "")
 }
 
 //export GoQuicSpdyClientStreamOnTrailingHeadersComplete
-func GoQuicSpdyClientStreamOnTrailingHeadersComplete(quic_client_stream_key int64, headers_c *C.struct_GoSpdyHeader) {
+func GoQuicSpdyClientStreamOnTrailingHeadersComplete(quic_client_stream_key int64, headers_c *C.struct_GoHeaderBlock) {
 	stream := quicClientStreamPtr.Get(quic_client_stream_key)
 	header := createHeader(headers_c)
 	stream.UserStream().OnTrailingHeadersComplete(header)
@@ -4,168 +4,99 @@ package goquic
 // #include "src/adaptor.h"
 import "C"
 import (
-	"container/heap"
+	"math"
 	"time"
+	"unsafe"
 )
 
-type HeapItem struct {
-	alarm *GoQuicAlarm
-
-	// This duration should be managed explicitly by heap, and should not be shared with GoQuicAlarm to be thread-safe.
-	deadline int64
-
-	// Negative value means this alarm is not in heap, otherwise this alarm is idx-th element in heap.
-	heapIdx int
-
-	// Inserted order, to be used at tie-breaking
-	insertOrd int
-}
-
-type AlarmHeap struct {
-	items     []*HeapItem
-	insertNum int
-}
-
+// TaskRunner drives the QUIC alarms of one event loop. The alarms themselves
+// live in a C++ timer wheel (GoQuicTimerWheel); Go only watches the wheel's
+// next deadline and calls DoTasks once it has passed.
+//
 // This TaskRunner is NOT THREAD SAFE (and NEED NOT TO BE) so be careful
-// All heap operations should be called in a mainloop, not seperated goroutine
+// All operations should be called in a mainloop, not seperated goroutine
 type TaskRunner struct {
-	alarmList map[*GoQuicAlarm]*HeapItem
-
-	alarmHeap   *AlarmHeap
-	deadlineTop int64
-	timer       *time.Timer
-}
-
-func (ht *AlarmHeap) Len() int { return len(ht.items) }
-
-func (ht *AlarmHeap) Less(i, j int) bool {
-	if ht.items[i].deadline == ht.items[j].deadline {
-		return ht.items[i].insertOrd < ht.items[j].insertOrd
-	}
-	return ht.items[i].deadline < ht.items[j].deadline
-}
-
-func (ht *AlarmHeap) Swap(i, j int) {
-	ht.items[i], ht.items[j] = ht.items[j], ht.items[i]
-	ht.items[i].heapIdx = i
-	ht.items[j].heapIdx = j
-}
+	timerWheel unsafe.Pointer
+	state      *C.struct_GoQuicTimerWheelState
 
-func (ht *AlarmHeap) Push(x interface{}) {
-	n := len(ht.items)
-	item := x.(*HeapItem)
-	item.heapIdx = n
-	ht.insertNum += 1
-	item.insertOrd = ht.insertNum
-	ht.items = append(ht.items, item)
-}
+	// Go time at which state.Now was sampled, used to translate QuicClock
+	// deadlines into Go durations.
+	syncTime time.Time
 
-func (ht *AlarmHeap) Pop() interface{} {
-	old := ht.items
-	n := len(old)
-	item := old[n-1]
-	item.heapIdx = -1 // for safety
-	ht.items = old[0 : n-1]
-	return item
-}
-
-func newAlarmHeap() *AlarmHeap {
-	return &AlarmHeap{make([]*HeapItem, 0), 0}
+	timer         *time.Timer
+	timerDeadline int64 // Wheel deadline the timer is currently armed for
 }
 
 func CreateTaskRunner() *TaskRunner {
+	timerWheel := C.create_go_quic_timer_wheel()
 	taskRunner := &TaskRunner{
-		alarmList: make(map[*GoQuicAlarm]*HeapItem),
-		alarmHeap: newAlarmHeap(),
-		timer:     time.NewTimer(time.Duration(200*365*24) * time.Hour), // ~ 200 year
+		timerWheel:    unsafe.Pointer(timerWheel),
+		state:         C.go_quic_timer_wheel_state(timerWheel),
+		syncTime:      time.Now(),
+		timer:         time.NewTimer(time.Duration(200*365*24) * time.Hour), // ~ 200 year
+		timerDeadline: math.MaxInt64,
 	}
 
 	return taskRunner
 }
 
-func (t *TaskRunner) RunAlarm(alarm *GoQuicAlarm) {
-	item := t.alarmList[alarm]
-	item.deadline = item.alarm.deadline
-	if item.heapIdx < 0 {
-		heap.Push(t.alarmHeap, item)
-	} else {
-		heap.Fix(t.alarmHeap, item.heapIdx)
-	}
-	if t.alarmHeap.Len() != 0 && t.deadlineTop != t.alarmHeap.items[0].deadline {
-		t.resetTimer()
+// DoTasks fires every expired alarm with a single call into C++.
+func (t *TaskRunner) DoTasks() {
+	if t.timerWheel == nil {
+		return
 	}
-}
+	C.go_quic_timer_wheel_fire_expired(t.timerWheel)
+	t.syncTime = time.Now()
 
-func (t *TaskRunner) CancelAlarm(alarm *GoQuicAlarm) {
-	item := t.alarmList[alarm]
-	if item.heapIdx >= 0 {
-		heap.Remove(t.alarmHeap, item.heapIdx)
-	}
-	if t.alarmHeap.Len() != 0 && t.deadlineTop != t.alarmHeap.items[0].deadline {
-		t.resetTimer()
-	}
+	// The timer has either fired or is about to be re-armed anyway.
+	t.timerDeadline = -1
 }
 
-func (t *TaskRunner) resetTimer() {
-	if t.alarmHeap.Len() == 0 {
-		return
+// WaitTimer returns a channel that fires when the earliest alarm is due. It
+// should be called on every loop iteration, as alarms scheduled while
+// processing packets only move the deadline in the shared wheel state.
+func (t *TaskRunner) WaitTimer() <-chan time.Time {
+	if t.state == nil {
+		return t.timer.C
 	}
 
-	t.deadlineTop = t.alarmHeap.items[0].deadline
-
-	now := t.alarmHeap.items[0].alarm.Now()
-	duration_i64 := t.alarmHeap.items[0].deadline - now
-	if duration_i64 < 0 {
-		duration_i64 = 0
+	deadline := int64(t.state.Next_deadline)
+	if deadline == t.timerDeadline {
+		return t.timer.C
 	}
-	// C++ clocks: Microseconds
-	// Go duration: Nanoseconds
-	duration := time.Duration(duration_i64) * time.Microsecond
+	t.timerDeadline = deadline
 
-	t.timer.Reset(duration)
-}
-
-func (t *TaskRunner) DoTasks() {
-	if t.alarmHeap.Len() == 0 {
-		return
-	}
-	now := t.alarmHeap.items[0].alarm.Now()
-
-	taskItems := make([]*HeapItem, 0)
-
-	for t.alarmHeap.Len() > 0 {
-		duration_i64 := t.alarmHeap.items[0].deadline - now
-		if duration_i64 < 0 {
-			item := heap.Pop(t.alarmHeap).(*HeapItem)
-			taskItems = append(taskItems, item)
-		} else {
-			//			fmt.Println(unsafe.Pointer(t), "next alarm will be called after", duration_i64)
-			break
+	if !t.timer.Stop() {
+		select {
+		case <-t.timer.C:
+		default:
 		}
 	}
 
-	for _, item := range taskItems {
-		item.alarm.OnAlarm()
+	if deadline == math.MaxInt64 {
+		return t.timer.C
 	}
 
-	t.resetTimer()
-}
+	// C++ clocks: Microseconds
+	// Go duration: Nanoseconds
+	duration := time.Duration(deadline-int64(t.state.Now))*time.Microsecond - time.Since(t.syncTime)
+	if duration < 0 {
+		duration = 0
+	}
+	t.timer.Reset(duration)
 
-func (t *TaskRunner) WaitTimer() <-chan time.Time {
 	return t.timer.C
 }
 
-func (t *TaskRunner) RegisterAlarm(alarm *GoQuicAlarm) {
-	// This is to prevent garbage collection. This is cleaned up on UnregisterAlarm()
-	t.alarmList[alarm] = &HeapItem{
-		alarm:   alarm,
-		heapIdx: -1,
+//export ReleaseTaskRunner
+func ReleaseTaskRunner(task_runner_key int64) {
+	t := taskRunnerPtr.Get(task_runner_key)
+	taskRunnerPtr.Del(task_runner_key)
+	if t == nil || t.timerWheel == nil {
+		return
 	}
-}
 
-func (t *TaskRunner) UnregisterAlarm(alarm *GoQuicAlarm) {
-	if t.alarmList[alarm].heapIdx != -1 {
-		t.CancelAlarm(alarm)
-	}
-	delete(t.alarmList, alarm)
+	C.delete_go_quic_timer_wheel(t.timerWheel)
+	t.timerWheel = nil
+	t.state = nil
 }
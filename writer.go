@@ -5,6 +5,7 @@ package goquic
 import "C"
 import (
 	"net"
+	"sync/atomic"
 	"unsafe"
 )
 
@@ -12,47 +13,115 @@ type UdpData struct {
 	Addr *net.UDPAddr
 	Buf  []byte
 	N    int
+
+	// Kernel receive time in UNIX microseconds, or zero if unknown.
+	Timestamp int64
 }
 
+// ServerWriter receives outgoing packets in batches, one slice per flush of
+// the C++ writer.
+//
+// Once more than 3/4 of Ch is queued the C++ writer is told it is blocked, so
+// connections stop writing instead of piling up packets. The goroutine
+// draining Ch calls Drained after each batch, which signals Writable once the
+// queue is back under 1/4 of its capacity.
 type ServerWriter struct {
-	Ch chan UdpData
+	Ch       chan []UdpData
+	Writable chan struct{}
+
+	blocked int32
 }
 
 type ClientWriter struct {
 	Ch chan UdpData
 }
 
-func NewServerWriter(ch chan UdpData) *ServerWriter {
-	return &ServerWriter{ch}
+func NewServerWriter(ch chan []UdpData) *ServerWriter {
+	return &ServerWriter{Ch: ch, Writable: make(chan struct{}, 1)}
+}
+
+func (w *ServerWriter) highWatermark() int {
+	return cap(w.Ch) * 3 / 4
+}
+
+func (w *ServerWriter) lowWatermark() int {
+	return cap(w.Ch) / 4
+}
+
+// enqueue queues |batch| and reports whether the writer can take more.
+func (w *ServerWriter) enqueue(batch []UdpData) bool {
+	w.Ch <- batch
+	if len(w.Ch) < w.highWatermark() {
+		return true
+	}
+
+	// Set the flag before looking at the queue again, so that Drained either
+	// sees it or the queue is still long enough for a later Drained call to.
+	atomic.StoreInt32(&w.blocked, 1)
+	if len(w.Ch) >= w.highWatermark() {
+		return false
+	}
+	// Drained in the meantime. If Drained already cleared the flag, Writable
+	// has a spurious wakeup in it, which is harmless.
+	atomic.CompareAndSwapInt32(&w.blocked, 1, 0)
+	return true
+}
+
+// Drained should be called by the consumer of Ch after writing each batch.
+func (w *ServerWriter) Drained() {
+	if atomic.LoadInt32(&w.blocked) == 0 || len(w.Ch) > w.lowWatermark() {
+		return
+	}
+	if atomic.CompareAndSwapInt32(&w.blocked, 1, 0) {
+		select {
+		case w.Writable <- struct{}{}:
+		default:
+		}
+	}
 }
 
 func NewClientWriter(ch chan UdpData) *ClientWriter {
 	return &ClientWriter{ch}
 }
 
-func writeToUDP(go_writer_key int64, peer_ip unsafe.Pointer, peer_ip_sz C.size_t, peer_port uint16, buffer_c unsafe.Pointer, length_c C.size_t, isServer bool) {
-	buf := C.GoBytes(buffer_c, C.int(length_c))
+// WriteToUDPBatch returns 0 if the egress queue is backed up, in which case the
+// C++ writer reports WRITE_STATUS_BLOCKED until Writable fires.
+//
+//export WriteToUDPBatch
+func WriteToUDPBatch(go_writer_key int64, descs_c *C.struct_GoPacketDesc, num_descs C.size_t, buffer_c *C.char, length_c C.size_t) C.int {
+	// One copy for the whole batch; packets are sub-slices of it.
+	buf := C.GoBytes(unsafe.Pointer(buffer_c), C.int(length_c))
+	descs := (*[1 << 20]C.struct_GoPacketDesc)(unsafe.Pointer(descs_c))[:num_descs:num_descs]
 
-	if isServer {
-		peer_addr := &net.UDPAddr{
-			IP:   net.IP(C.GoBytes(peer_ip, C.int(peer_ip_sz))),
-			Port: int(peer_port),
+	batch := make([]UdpData, len(descs))
+	var peer_addr *net.UDPAddr
+	for i := range descs {
+		desc := &descs[i]
+		if i == 0 || !samePeer(desc, &descs[i-1]) {
+			peer_addr = &net.UDPAddr{
+				IP:   net.IP(C.GoBytes(unsafe.Pointer(&desc.Peer_ip[0]), desc.Peer_ip_len)),
+				Port: int(desc.Peer_port),
+			}
 		}
 
-		serverWriterPtr.Get(go_writer_key).Ch <- UdpData{Buf: buf, Addr: peer_addr, N: int(length_c)}
-	} else {
-		clientWriterPtr.Get(go_writer_key).Ch <- UdpData{Buf: buf, N: int(length_c)}
+		n := int(desc.Length)
+		batch[i] = UdpData{Addr: peer_addr, Buf: buf[desc.Offset : int(desc.Offset)+n], N: n}
 	}
+
+	if !serverWriterPtr.Get(go_writer_key).enqueue(batch) {
+		return 0
+	}
+	return 1
 }
 
-//export WriteToUDP
-func WriteToUDP(go_writer_key int64, peer_ip unsafe.Pointer, peer_ip_sz C.size_t, peer_port uint16, buffer_c unsafe.Pointer, length_c C.size_t) {
-	writeToUDP(go_writer_key, peer_ip, peer_ip_sz, peer_port, buffer_c, length_c, true)
+func samePeer(a, b *C.struct_GoPacketDesc) bool {
+	return a.Peer_port == b.Peer_port && a.Peer_ip_len == b.Peer_ip_len && a.Peer_ip == b.Peer_ip
 }
 
 //export WriteToUDPClient
 func WriteToUDPClient(go_writer_key int64, peer_ip unsafe.Pointer, peer_ip_sz C.size_t, peer_port uint16, buffer_c unsafe.Pointer, length_c C.size_t) {
-	writeToUDP(go_writer_key, peer_ip, peer_ip_sz, peer_port, buffer_c, length_c, false)
+	buf := C.GoBytes(buffer_c, C.int(length_c))
+	clientWriterPtr.Get(go_writer_key).Ch <- UdpData{Buf: buf, N: int(length_c)}
 }
 
 //export ReleaseClientWriter
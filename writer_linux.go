@@ -0,0 +1,218 @@
+package goquic
+
+// #include <sys/syscall.h>
+import "C"
+import (
+	"errors"
+	"net"
+	"runtime"
+	"syscall"
+	"unsafe"
+)
+
+const (
+	solUDP     = 17  // SOL_UDP
+	udpSegment = 103 // UDP_SEGMENT, Linux 4.18+
+
+	maxSendmmsgBatch  = 64
+	maxGSOSegments    = 64
+	maxGSOPayloadSize = 65000
+)
+
+var errUnsupportedAddr = errors.New("address is not representable as a sockaddr")
+
+// Mirrors struct mmsghdr from <sys/socket.h>.
+type mmsghdr struct {
+	Hdr syscall.Msghdr
+	Len uint32
+}
+
+// batchUDPWriter sends the packets of one writer batch with as few syscalls
+// as possible: packets are coalesced into sendmmsg calls, and runs of
+// same-sized packets to the same peer are sent as a single UDP_SEGMENT (GSO)
+// message. If the kernel refuses either feature the writer falls back, first
+// to sendmmsg without GSO, then to plain WriteToUDP.
+type batchUDPWriter struct {
+	conn *net.UDPConn
+	raw  syscall.RawConn
+
+	useMmsg bool
+	useGSO  bool
+
+	msgs    []mmsghdr
+	iovs    []syscall.Iovec
+	names   []syscall.RawSockaddrInet6
+	oob     []byte
+	covered []int // Number of packets carried by each message
+}
+
+func newBatchUDPWriter(conn *net.UDPConn) *batchUDPWriter {
+	w := &batchUDPWriter{
+		conn:  conn,
+		msgs:  make([]mmsghdr, maxSendmmsgBatch),
+		iovs:  make([]syscall.Iovec, maxSendmmsgBatch*maxGSOSegments),
+		names: make([]syscall.RawSockaddrInet6, maxSendmmsgBatch),
+		oob:   make([]byte, maxSendmmsgBatch*syscall.CmsgSpace(2)),
+
+		covered: make([]int, 0, maxSendmmsgBatch),
+	}
+
+	raw, err := conn.SyscallConn()
+	if err == nil {
+		w.raw = raw
+		w.useMmsg = true
+		w.useGSO = true
+	}
+	return w
+}
+
+func (w *batchUDPWriter) WriteBatch(batch []UdpData) {
+	for len(batch) > 0 && w.useMmsg {
+		n, err := w.sendmmsg(batch)
+		if err != nil {
+			if w.useGSO && (err == syscall.EIO || err == syscall.EINVAL || err == syscall.ENOPROTOOPT) {
+				// No GSO support on this kernel or NIC. Retry the same packets
+				// without segmentation offload.
+				w.useGSO = false
+				continue
+			}
+			if err == syscall.ENOSYS {
+				w.useMmsg = false
+			}
+			break
+		}
+		batch = batch[n:]
+	}
+
+	for _, dat := range batch {
+		w.conn.WriteToUDP(dat.Buf[:dat.N], dat.Addr)
+	}
+}
+
+// sendmmsg sends a prefix of |batch| with one syscall and returns the number
+// of packets that were sent.
+func (w *batchUDPWriter) sendmmsg(batch []UdpData) (int, error) {
+	var nmsgs, niovs, noob int
+	covered := w.covered[:0]
+
+	i := 0
+	for i < len(batch) && nmsgs < len(w.msgs) {
+		first := &batch[i]
+		segments := 1
+		payload := first.N
+		if w.useGSO {
+			for i+segments < len(batch) && segments < maxGSOSegments {
+				next := &batch[i+segments]
+				if next.N > first.N || payload+next.N > maxGSOPayloadSize || !sameUDPAddr(next.Addr, first.Addr) {
+					break
+				}
+				payload += next.N
+				segments++
+				if next.N < first.N {
+					// Only the last segment may be shorter.
+					break
+				}
+			}
+		}
+
+		msg := &w.msgs[nmsgs]
+		*msg = mmsghdr{}
+
+		name := &w.names[nmsgs]
+		namelen, ok := fillSockaddr(name, first.Addr)
+		if !ok {
+			// Not representable as a raw sockaddr; leave it to WriteToUDP.
+			break
+		}
+		msg.Hdr.Name = (*byte)(unsafe.Pointer(name))
+		msg.Hdr.Namelen = namelen
+
+		for j := 0; j < segments; j++ {
+			dat := &batch[i+j]
+			iov := &w.iovs[niovs+j]
+			iov.Base = &dat.Buf[0]
+			iov.SetLen(dat.N)
+		}
+		msg.Hdr.Iov = &w.iovs[niovs]
+		setIovlen(&msg.Hdr, segments)
+		niovs += segments
+
+		if segments > 1 {
+			space := syscall.CmsgSpace(2)
+			oob := w.oob[noob : noob+space]
+			for k := range oob {
+				oob[k] = 0
+			}
+			cmsg := (*syscall.Cmsghdr)(unsafe.Pointer(&oob[0]))
+			cmsg.Level = solUDP
+			cmsg.Type = udpSegment
+			cmsg.SetLen(syscall.CmsgLen(2))
+			*(*uint16)(unsafe.Pointer(&oob[syscall.CmsgLen(0)])) = uint16(first.N)
+			msg.Hdr.Control = &oob[0]
+			msg.Hdr.SetControllen(space)
+			noob += space
+		}
+
+		covered = append(covered, segments)
+		nmsgs++
+		i += segments
+	}
+
+	if nmsgs == 0 {
+		return 0, errUnsupportedAddr
+	}
+
+	var sent int
+	var errno syscall.Errno
+	err := w.raw.Write(func(fd uintptr) bool {
+		r, _, e := syscall.Syscall6(uintptr(C.SYS_sendmmsg), fd,
+			uintptr(unsafe.Pointer(&w.msgs[0])), uintptr(nmsgs), 0, 0, 0)
+		if e == syscall.EAGAIN {
+			return false
+		}
+		sent, errno = int(r), e
+		return true
+	})
+	runtime.KeepAlive(batch)
+	if err != nil {
+		return 0, err
+	}
+	if errno != 0 {
+		return 0, errno
+	}
+
+	n := 0
+	for _, c := range covered[:sent] {
+		n += c
+	}
+	return n, nil
+}
+
+func sameUDPAddr(a, b *net.UDPAddr) bool {
+	return a == b || (a.Port == b.Port && a.IP.Equal(b.IP))
+}
+
+func fillSockaddr(sa *syscall.RawSockaddrInet6, addr *net.UDPAddr) (uint32, bool) {
+	*sa = syscall.RawSockaddrInet6{}
+	port := (*[2]byte)(unsafe.Pointer(&sa.Port))
+	port[0] = byte(addr.Port >> 8)
+	port[1] = byte(addr.Port)
+
+	if ip4 := addr.IP.To4(); ip4 != nil {
+		sa4 := (*syscall.RawSockaddrInet4)(unsafe.Pointer(sa))
+		sa4.Family = syscall.AF_INET
+		copy(sa4.Addr[:], ip4)
+		return syscall.SizeofSockaddrInet4, true
+	}
+	if len(addr.IP) == net.IPv6len {
+		sa.Family = syscall.AF_INET6
+		copy(sa.Addr[:], addr.IP)
+		return syscall.SizeofSockaddrInet6, true
+	}
+	return 0, false
+}
+
+// Msghdr.Iovlen is a size_t, whose Go type differs between architectures.
+func setIovlen(msg *syscall.Msghdr, n int) {
+	*(*uintptr)(unsafe.Pointer(&msg.Iovlen)) = uintptr(n)
+}
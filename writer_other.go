@@ -0,0 +1,22 @@
+//go:build !linux
+// +build !linux
+
+package goquic
+
+import "net"
+
+// batchUDPWriter writes one datagram per syscall on platforms without
+// sendmmsg.
+type batchUDPWriter struct {
+	conn *net.UDPConn
+}
+
+func newBatchUDPWriter(conn *net.UDPConn) *batchUDPWriter {
+	return &batchUDPWriter{conn: conn}
+}
+
+func (w *batchUDPWriter) WriteBatch(batch []UdpData) {
+	for _, dat := range batch {
+		w.conn.WriteToUDP(dat.Buf[:dat.N], dat.Addr)
+	}
+}